@@ -24,6 +24,7 @@
 #include <windows.h>
 #endif
 #include <stddef.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <map>
@@ -31,6 +32,8 @@
 #include <functional>
 #include <set>
 #include <mutex>
+#include <atomic>
+#include <type_traits>
 #include "binaryninjacore.h"
 #include "json/json.h"
 
@@ -371,6 +374,65 @@ namespace BinaryNinja
 	Ref<MainThreadAction> ExecuteOnMainThread(const std::function<void()>& action);
 	void ExecuteOnMainThreadAndWait(const std::function<void()>& action);
 
+	struct DataBufferArenaStats
+	{
+		uint64_t reused;
+		uint64_t allocated;
+		uint64_t recycled;
+		uint64_t freed;
+	};
+
+	/*! DataBufferArena keeps freed core buffers in per-thread size class free lists while it is in
+	    scope. DataBuffers created on the owning thread take a cached buffer when one is available,
+	    and buffers the arena handed out are returned to its free lists when they are destroyed on
+	    that thread. Buffers that did not come from the arena, or that grew past their size class,
+	    are freed as usual. The free lists hold at most maxCachedBytes of storage in total.
+	    Arenas nest; the innermost arena on a thread is the active one, and a buffer destroyed
+	    under a nested arena still goes back to the arena that created it. Buffers that outlive the
+	    arena are simply freed when they are destroyed. Cached buffers are released when the arena
+	    is destroyed.
+	*/
+	class DataBufferArena
+	{
+		static const size_t MinSizeClass = 4;
+		static const size_t MaxSizeClass = 20;
+		static const size_t SizeClassCount = MaxSizeClass - MinSizeClass + 1;
+
+		static const size_t MaxTrackedBuffers = 4096;
+
+		DataBufferArena* m_previous;
+		size_t m_maxCachedBytes;
+		size_t m_cachedBytes;
+		std::vector<BNDataBuffer*> m_free[SizeClassCount];
+		std::map<BNDataBuffer*, size_t> m_owned;
+		DataBufferArenaStats m_stats;
+
+		DataBufferArena(const DataBufferArena&) = delete;
+		DataBufferArena& operator=(const DataBufferArena&) = delete;
+
+		BNDataBuffer* Acquire(size_t len);
+		bool Recycle(BNDataBuffer* buf, size_t shift);
+
+		static BNDataBuffer* CreateBuffer(const void* data, size_t len);
+		static void FreeBuffer(BNDataBuffer* buf);
+
+		friend class DataBuffer;
+
+	public:
+		DataBufferArena(size_t maxCachedBytes = 0x400000);
+		~DataBufferArena();
+
+		static DataBufferArena* GetCurrent();
+
+		DataBufferArenaStats GetStats() const { return m_stats; }
+		size_t GetCachedBufferCount() const;
+		size_t GetCachedBytes() const { return m_cachedBytes; }
+		void Trim();
+	};
+
+	/*! DataBuffer owns a core byte buffer. Copies duplicate the contents; moves transfer ownership without
+	    copying, after which the moved-from buffer may only be assigned to or destroyed.
+	*/
 	class DataBuffer
 	{
 		BNDataBuffer* m_buffer;
@@ -380,10 +442,12 @@ namespace BinaryNinja
 		DataBuffer(size_t len);
 		DataBuffer(const void* data, size_t len);
 		DataBuffer(const DataBuffer& buf);
+		DataBuffer(DataBuffer&& buf) NOEXCEPT;
 		DataBuffer(BNDataBuffer* buf);
 		~DataBuffer();
 
 		DataBuffer& operator=(const DataBuffer& buf);
+		DataBuffer& operator=(DataBuffer&& buf) NOEXCEPT;
 
 		BNDataBuffer* GetBufferObject() const { return m_buffer; }
 
@@ -409,16 +473,61 @@ namespace BinaryNinja
 		std::string ToBase64() const;
 		static DataBuffer FromBase64(const std::string& src);
 
+		/*! Encodes the contents as two hex digits per byte. */
+		std::string ToHexString(bool upperCase = false) const;
+		/*! Decodes a string of hex digit pairs (either case). Returns an empty buffer if src has an odd
+		    length or contains anything other than hex digits.
+		*/
+		static DataBuffer FromHexString(const std::string& src);
+
 		bool ZlibCompress(DataBuffer& output) const;
 		bool ZlibDecompress(DataBuffer& output) const;
 	};
 
+	/*! DataBufferView is a non-owning pointer and length over bytes held elsewhere (a DataBuffer, a
+	    std::vector, a string or a mapped region). It never copies, so the underlying storage must outlive
+	    the view and must not be resized while the view is in use.
+	*/
+	class DataBufferView
+	{
+		const uint8_t* m_data;
+		size_t m_length;
+
+	public:
+		DataBufferView(): m_data(nullptr), m_length(0) {}
+		DataBufferView(const void* data, size_t len): m_data((const uint8_t*)data), m_length(len) {}
+		DataBufferView(const DataBuffer& buf): m_data((const uint8_t*)buf.GetData()), m_length(buf.GetLength()) {}
+		DataBufferView(const std::vector<uint8_t>& data): m_data(data.data()), m_length(data.size()) {}
+		DataBufferView(const std::string& data): m_data((const uint8_t*)data.data()), m_length(data.size()) {}
+
+		const void* GetData() const { return m_data; }
+		const void* GetDataAt(size_t offset) const { return m_data + offset; }
+		size_t GetLength() const { return m_length; }
+		bool IsEmpty() const { return m_length == 0; }
+
+		const uint8_t* begin() const { return m_data; }
+		const uint8_t* end() const { return m_data + m_length; }
+		const uint8_t& operator[](size_t offset) const { return m_data[offset]; }
+
+		DataBufferView GetSlice(size_t start, size_t len) const
+		{
+			if (start > m_length)
+				start = m_length;
+			if (len > (m_length - start))
+				len = m_length - start;
+			return DataBufferView(m_data + start, len);
+		}
+
+		DataBuffer ToDataBuffer() const { return DataBuffer(m_data, m_length); }
+	};
+
 	class TemporaryFile: public CoreRefCountObject<BNTemporaryFile, BNNewTemporaryFileReference, BNFreeTemporaryFile>
 	{
 	public:
 		TemporaryFile();
 		TemporaryFile(const DataBuffer& contents);
 		TemporaryFile(const std::string& contents);
+		TemporaryFile(const DataBufferView& contents);
 		TemporaryFile(BNTemporaryFile* file);
 
 		bool IsValid() const { return m_object != nullptr; }
@@ -426,6 +535,70 @@ namespace BinaryNinja
 		DataBuffer GetContents();
 	};
 
+	class BinaryView;
+	struct ZlibStreamState;
+
+	/*! Incremental zlib compression. Input is fed in pieces and compressed output is handed to the
+	    output callback one chunk at a time, so memory use is bounded by the chunk size rather than
+	    the size of the stream. The callback can return false to abort. After a failure, HasError is
+	    set and GetErrorMessage describes the cause, including view data that could not be read.
+	*/
+	class ZlibCompressor
+	{
+	public:
+		typedef std::function<bool(const DataBufferView& chunk)> OutputCallback;
+
+	private:
+		ZlibStreamState* m_state;
+
+		ZlibCompressor(const ZlibCompressor&) = delete;
+		ZlibCompressor& operator=(const ZlibCompressor&) = delete;
+
+	public:
+		ZlibCompressor(const OutputCallback& output, int level = -1, size_t chunkSize = 0x10000);
+		~ZlibCompressor();
+
+		bool Feed(const DataBufferView& input);
+		bool Feed(BinaryView* view, uint64_t offset, uint64_t len);
+		bool Finish();
+
+		bool IsFinished() const;
+		bool HasError() const;
+		std::string GetErrorMessage() const;
+		uint64_t GetTotalInput() const;
+		uint64_t GetTotalOutput() const;
+	};
+
+	/*! Incremental zlib decompression, the counterpart to ZlibCompressor. Finish returns false if the
+	    input ended before the end of the compressed stream. Input past the end of the stream is
+	    ignored.
+	*/
+	class ZlibDecompressor
+	{
+	public:
+		typedef std::function<bool(const DataBufferView& chunk)> OutputCallback;
+
+	private:
+		ZlibStreamState* m_state;
+
+		ZlibDecompressor(const ZlibDecompressor&) = delete;
+		ZlibDecompressor& operator=(const ZlibDecompressor&) = delete;
+
+	public:
+		ZlibDecompressor(const OutputCallback& output, size_t chunkSize = 0x10000);
+		~ZlibDecompressor();
+
+		bool Feed(const DataBufferView& input);
+		bool Feed(BinaryView* view, uint64_t offset, uint64_t len);
+		bool Finish();
+
+		bool IsFinished() const;
+		bool HasError() const;
+		std::string GetErrorMessage() const;
+		uint64_t GetTotalInput() const;
+		uint64_t GetTotalOutput() const;
+	};
+
 	class NavigationHandler
 	{
 	private:
@@ -689,6 +862,297 @@ namespace BinaryNinja
 
 	struct NameAndType;
 
+	struct ReadRange
+	{
+		uint64_t offset;
+		size_t length;
+	};
+
+	/*! Code references to a set of target addresses in compressed sparse row form. The references to
+	    targets[i] are entries offsets[i] to offsets[i + 1] of sources (the referencing instruction) and
+	    functions (the start of the function containing it), sorted by source address. Targets are
+	    sorted and unique.
+	*/
+	struct CodeReferenceTable
+	{
+		std::vector<uint64_t> targets;
+		std::vector<size_t> offsets;
+		std::vector<uint64_t> sources;
+		std::vector<uint64_t> functions;
+
+		void Clear();
+		/*! Returns the index of target in targets, or targets.size() if it was not queried. */
+		size_t GetTargetIndex(uint64_t target) const;
+		size_t GetReferenceCount(size_t i) const { return offsets[i + 1] - offsets[i]; }
+	};
+
+	/*! A pointer stored in the view at source whose value, target, is a valid address of the view. */
+	struct DataReference
+	{
+		uint64_t source;
+		uint64_t target;
+	};
+
+	/*! A block of view contents passed to a BinaryView::ScanData callback. Matches should only be reported
+	    if they start within the first scanLength bytes; the remaining bytes repeat at the start of the
+	    next block and are only provided so that matches crossing the block boundary can be completed.
+	*/
+	struct DataScanBlock
+	{
+		uint64_t address;
+		const uint8_t* data;
+		size_t length;
+		size_t scanLength;
+	};
+
+	/*! Controls how the parallel search functions on BinaryView divide their work. A thread count of zero
+	    uses one thread per hardware thread; set it lower to leave room for analysis running at the same
+	    time. If cancel is set, it is polled between blocks and the search stops once it becomes true.
+	*/
+	struct ParallelSearchSettings
+	{
+		size_t threadCount;
+		uint64_t chunkSize;
+		const std::atomic<bool>* cancel;
+
+		ParallelSearchSettings(): threadCount(0), chunkSize(0x400000), cancel(nullptr) {}
+	};
+
+	/*! Selects the encodings and minimum length (in characters) for BinaryView::FindStrings. Characters are
+	    printable ASCII plus tab, carriage return and line feed; wide encodings must encode them with
+	    zero upper bytes. Big endian wide strings are reported with the same string types as little
+	    endian ones.
+	*/
+	struct StringScanSettings
+	{
+		size_t minLength;
+		bool ascii;
+		bool utf16LittleEndian;
+		bool utf16BigEndian;
+		bool utf32LittleEndian;
+		bool utf32BigEndian;
+
+		StringScanSettings(): minLength(4), ascii(true), utf16LittleEndian(true), utf16BigEndian(false),
+			utf32LittleEndian(false), utf32BigEndian(false) {}
+	};
+
+	/*! BytePattern is a byte signature with a per-byte mask, so that individual bits (typically whole bytes
+	    or nibbles) can be left as wildcards.
+	*/
+	class BytePattern
+	{
+		std::vector<uint8_t> m_bytes;
+		std::vector<uint8_t> m_mask;
+		size_t m_firstAnchor;
+		size_t m_secondAnchor;
+
+		void ChooseAnchors();
+
+	public:
+		BytePattern();
+		BytePattern(const std::vector<uint8_t>& bytes);
+		BytePattern(const std::vector<uint8_t>& bytes, const std::vector<uint8_t>& mask);
+
+		/*! Parses a pattern of hex byte pairs such as "48 8B ?? ?? E8". A '?' in place of a hex digit
+		    leaves that nibble unmatched, and a lone '?' token matches any byte. Whitespace between
+		    bytes is optional.
+		*/
+		static bool Parse(const std::string& text, BytePattern& result);
+
+		const std::vector<uint8_t>& GetBytes() const { return m_bytes; }
+		const std::vector<uint8_t>& GetMask() const { return m_mask; }
+		size_t GetLength() const { return m_bytes.size(); }
+		bool IsEmpty() const { return m_bytes.empty(); }
+
+		bool Matches(const uint8_t* data) const;
+		bool Find(const uint8_t* data, size_t len, size_t start, size_t& result) const;
+	};
+
+	struct PatternMatch
+	{
+		size_t pattern;
+		uint64_t address;
+	};
+
+	struct RegexMatch
+	{
+		uint64_t address;
+		size_t length;
+	};
+
+	struct BinaryRegexProgram;
+
+	/*! BinaryRegex is a regular expression over raw bytes. Patterns are compiled to an NFA once and searched
+	    with a lazily built DFA that reads each byte once, so search time is linear in the size of the data.
+	    The cost per byte grows with the number of candidate matches in progress at once, which is bounded
+	    by the size of the pattern. The DFA state cache is bounded and is flushed when it fills up.
+
+	    The syntax supports literals, '.', classes such as [^\x00-\x1f], the escapes \xHH, \n, \r, \t, \0,
+	    \d, \w and \s (with negated forms), groups, alternation and the quantifiers *, +, ? and {n,m}. '.'
+	    matches any byte. Matches are leftmost-longest and do not overlap. Match length is limited to
+	    maxMatchLength bytes, which is also how far view searches read past each block; if the longest
+	    match at a position is longer, the longest one within the limit is reported instead. A candidate
+	    that reaches the limit is not rescanned, so a match that starts inside it and shares its path
+	    through the pattern can be missed. Patterns that can match empty input are rejected.
+	*/
+	class BinaryRegex: public RefCountObject
+	{
+		BinaryRegexProgram* m_program;
+		size_t m_maxMatchLength;
+
+		BinaryRegex(BinaryRegexProgram* program, size_t maxMatchLength);
+		BinaryRegex(const BinaryRegex&) = delete;
+		BinaryRegex& operator=(const BinaryRegex&) = delete;
+
+	public:
+		~BinaryRegex();
+
+		static Ref<BinaryRegex> Compile(const std::string& pattern, std::string& errors,
+			BNFindFlag flags = NoFindFlags, size_t maxMatchLength = 0x1000);
+
+		size_t GetMaxMatchLength() const { return m_maxMatchLength; }
+
+		/*! Searches a buffer whose first byte is at the given address. Returns false if the callback
+		    stopped the search by returning false.
+		*/
+		bool Search(const uint8_t* data, size_t len, uint64_t address,
+			const std::function<bool(const RegexMatch& match)>& callback) const;
+		bool Search(BinaryView* view, uint64_t start, uint64_t end,
+			const std::function<bool(const RegexMatch& match)>& callback) const;
+	};
+
+	/*! MultiPatternMatcher is a compiled Aho-Corasick automaton over a set of byte patterns, so that any
+	    number of patterns can be found in a single pass over the data. Each pattern is indexed by its
+	    longest run of fully specified bytes, and any wildcard bytes around that run are checked when
+	    the run is found. Patterns without a fully specified byte are searched for separately.
+
+	    The matcher is immutable once constructed. A single instance can be shared between threads and
+	    reused for any number of views. Matches report the index of the pattern in the list passed to
+	    the constructor and are not delivered in address order.
+	*/
+	class MultiPatternMatcher: public RefCountObject
+	{
+		std::vector<BytePattern> m_patterns;
+		std::vector<size_t> m_keyOffsets;
+		std::vector<size_t> m_keyLengths;
+		std::vector<size_t> m_unindexed;
+		size_t m_maxLength;
+
+		uint32_t m_rootTransitions[256];
+		std::vector<uint32_t> m_edgeStart;
+		std::vector<uint8_t> m_edgeBytes;
+		std::vector<uint32_t> m_edgeTargets;
+		std::vector<uint32_t> m_fail;
+		std::vector<uint32_t> m_outputStart;
+		std::vector<uint32_t> m_outputs;
+		std::vector<uint32_t> m_outputLinks;
+
+		uint32_t GetNextState(uint32_t state, uint8_t value) const;
+		bool ScanBlock(const uint8_t* data, size_t len, size_t scanLength, uint64_t address,
+			const std::function<bool(const PatternMatch& match)>& callback) const;
+
+	public:
+		MultiPatternMatcher(const std::vector<BytePattern>& patterns);
+
+		size_t GetPatternCount() const { return m_patterns.size(); }
+		const BytePattern& GetPattern(size_t i) const { return m_patterns[i]; }
+		size_t GetStateCount() const { return m_fail.size(); }
+
+		/*! Scans a buffer whose first byte is at the given address. Only matches lying entirely within
+		    the buffer are reported. Returns false if the callback stopped the scan by returning false.
+		*/
+		bool Scan(const uint8_t* data, size_t len, uint64_t address,
+			const std::function<bool(const PatternMatch& match)>& callback) const;
+		bool Scan(BinaryView* view, uint64_t start, uint64_t end,
+			const std::function<bool(const PatternMatch& match)>& callback) const;
+	};
+
+	/*! SymbolCache holds Symbol objects for all of a view's symbols so that lookups by address and name
+	    return an existing object instead of calling into the core. Names are interned once in an open
+	    addressing hash table, which serves both raw name lookups and lookups by any of a symbol's
+	    names. Addresses are kept in a sorted array. Addresses added by updates go into a small sorted
+	    array of their own, which is merged into the main one once it grows past about the square root
+	    of the symbol count. Removed symbols and names no longer used by any symbol are dropped once
+	    they outnumber the live ones.
+
+	    A cache is attached to a view with BinaryView::EnableSymbolCache, after which symbols defined or
+	    undefined through that view object are reconciled with the core as they change. Symbols created
+	    elsewhere, such as by analysis, are only picked up by Update or Refresh. The cache holds its own
+	    reference to the core view, so it stays usable if it outlives the view object.
+	*/
+	class SymbolCache: public RefCountObject
+	{
+		static const uint32_t NoEntry = 0xffffffff;
+
+		struct Entry
+		{
+			Ref<Symbol> symbol;
+			uint64_t address;
+			uint32_t names[3];
+			bool live;
+		};
+
+		struct NameRecord
+		{
+			std::string name;
+			uint64_t hash;
+			std::vector<uint32_t> rawNameEntries;
+			std::vector<uint32_t> entries;
+		};
+
+		static const size_t MinRecentLimit = 64;
+
+		BNBinaryView* m_view;
+		std::mutex m_mutex;
+		std::vector<Entry> m_entries;
+		std::vector<NameRecord> m_names;
+		std::vector<uint32_t> m_nameTable;
+		std::vector<std::pair<uint64_t, uint32_t>> m_addresses;
+		std::vector<std::pair<uint64_t, uint32_t>> m_recentAddresses;
+		size_t m_liveCount;
+		size_t m_recentLimit;
+
+		static uint64_t HashName(const std::string& name);
+		uint32_t FindName(const std::string& name, uint64_t hash) const;
+		uint32_t InternName(const std::string& name);
+		uint32_t AddName(const std::string& name, uint64_t hash);
+		void GrowNameTable();
+		void SetRecentLimit();
+		void SortAddresses();
+		void MergeRecentAddresses();
+		uint32_t FindAddressIn(const std::vector<std::pair<uint64_t, uint32_t>>& addresses, uint64_t addr) const;
+		uint32_t FindAddress(uint64_t addr) const;
+		void AddAddress(uint64_t addr, uint32_t id);
+		uint32_t InsertEntry(Symbol* sym, uint64_t addr, const uint32_t* names);
+		uint32_t InsertSymbol(BNSymbol* sym);
+		void RemoveEntry(uint32_t entry);
+		void UpdateAddress(uint64_t addr);
+		void Compact();
+		void Clear();
+
+	public:
+		SymbolCache(BinaryView* view);
+		~SymbolCache();
+
+		/*! Discards the cache and loads the view's full symbol list again. */
+		void Refresh();
+		/*! Reconciles the cached symbols at the address and raw name of sym with the core. Call this after a
+		    symbol is defined or undefined without going through the view object owning the cache.
+		*/
+		void Update(Symbol* sym);
+
+		size_t GetCount();
+		size_t GetInternedNameCount();
+
+		Ref<Symbol> GetSymbolByAddress(uint64_t addr);
+		/*! Returns the cached symbol with the given raw name. When several symbols share it, such as static
+		    functions from different compilation units, the core is asked which one it would return.
+		*/
+		Ref<Symbol> GetSymbolByRawName(const std::string& name);
+		/*! Returns the symbols whose short, full or raw name is name. */
+		std::vector<Ref<Symbol>> GetSymbolsByName(const std::string& name);
+	};
+
 	/*! BinaryView is the base class for creating views on binary data (e.g. ELF, PE, Mach-O).
 	    BinaryView should be subclassed to create a new BinaryView
 	*/
@@ -734,6 +1198,9 @@ namespace BinaryNinja
 		void NotifyDataRemoved(uint64_t offset, uint64_t len);
 
 	private:
+		mutable std::mutex m_symbolCacheMutex;
+		Ref<SymbolCache> m_symbolCache;
+
 		static bool InitCallback(void* ctxt);
 		static void FreeCallback(void* ctxt);
 		static size_t ReadCallback(void* ctxt, void* dest, uint64_t offset, size_t len);
@@ -782,11 +1249,23 @@ namespace BinaryNinja
 		size_t Read(void* dest, uint64_t offset, size_t len);
 		DataBuffer ReadBuffer(uint64_t offset, size_t len);
 
+		/*! Reads a batch of ranges into dest, packed back to back in request order. Ranges that lie within
+		    maxGap bytes of each other are fetched with a single read. bytesRead receives the number of
+		    bytes read for each range; any bytes that could not be read are zero filled. Returns true
+		    if every range was read in full.
+		*/
+		bool ReadRanges(const std::vector<ReadRange>& ranges, void* dest, std::vector<size_t>& bytesRead,
+			size_t maxGap = 0x100);
+		bool ReadRanges(const std::vector<ReadRange>& ranges, DataBuffer& output, std::vector<size_t>& bytesRead,
+			size_t maxGap = 0x100);
+
 		size_t Write(uint64_t offset, const void* data, size_t len);
 		size_t WriteBuffer(uint64_t offset, const DataBuffer& data);
+		size_t WriteBuffer(uint64_t offset, const DataBufferView& data);
 
 		size_t Insert(uint64_t offset, const void* data, size_t len);
 		size_t InsertBuffer(uint64_t offset, const DataBuffer& data);
+		size_t InsertBuffer(uint64_t offset, const DataBufferView& data);
 
 		size_t Remove(uint64_t offset, uint64_t len);
 
@@ -848,6 +1327,12 @@ namespace BinaryNinja
 
 		std::vector<ReferenceSource> GetCodeReferences(uint64_t addr);
 		std::vector<ReferenceSource> GetCodeReferences(uint64_t addr, uint64_t len);
+		/*! Queries the code references to each of targets and stores them in result without creating
+		    Function or Architecture objects. Duplicate targets are queried once. Runs of nearby targets
+		    are first checked with a single range query, and targets in runs without any references
+		    are not queried individually.
+		*/
+		void GetCodeReferences(const std::vector<uint64_t>& targets, CodeReferenceTable& result);
 
 		Ref<Symbol> GetSymbolByAddress(uint64_t addr);
 		Ref<Symbol> GetSymbolByRawName(const std::string& name);
@@ -865,6 +1350,15 @@ namespace BinaryNinja
 
 		void DefineImportedFunction(Symbol* importAddressSym, Function* func);
 
+		/*! Attaches a SymbolCache to this view object. While it is attached, the symbol lookups by address
+		    and name are answered from the cache, and symbols defined or undefined through this object
+		    keep it current. The cache belongs to this object, not to the underlying view. The cache may be
+		    enabled or disabled while other threads are looking up symbols.
+		*/
+		void EnableSymbolCache();
+		void DisableSymbolCache();
+		Ref<SymbolCache> GetSymbolCache() const;
+
 		bool IsNeverBranchPatchAvailable(Architecture* arch, uint64_t addr);
 		bool IsAlwaysBranchPatchAvailable(Architecture* arch, uint64_t addr);
 		bool IsInvertBranchPatchAvailable(Architecture* arch, uint64_t addr);
@@ -910,6 +1404,55 @@ namespace BinaryNinja
 		void UndefineUserType(const std::string& name);
 
 		bool FindNextData(uint64_t start, const DataBuffer& data, uint64_t& result, BNFindFlag flags = NoFindFlags);
+		bool FindNextData(uint64_t start, const DataBufferView& data, uint64_t& result, BNFindFlag flags = NoFindFlags);
+
+		/*! Reads [start, end) in blocks and passes each to callback, skipping regions that cannot be read.
+		    Consecutive blocks within a readable region overlap by the given number of bytes. Returns
+		    false if the callback stopped the scan by returning false.
+		*/
+		bool ScanData(uint64_t start, uint64_t end, size_t overlap,
+			const std::function<bool(const DataScanBlock& block)>& callback, size_t blockSize = 0x100000);
+		bool FindNextPattern(uint64_t start, const BytePattern& pattern, uint64_t& result);
+		bool FindNextPattern(uint64_t start, uint64_t end, const BytePattern& pattern, uint64_t& result);
+		/*! Calls callback with the address of every match of pattern starting in [start, end), in address
+		    order. Returns false if the callback stopped the search by returning false.
+		*/
+		bool FindAllPattern(uint64_t start, uint64_t end, const BytePattern& pattern,
+			const std::function<bool(uint64_t address)>& callback);
+
+		/*! Parallel forms of the searches above. The range is split into chunks that are scanned on a pool
+		    of worker threads, with each chunk reading past its end by the pattern length minus one so
+		    matches on chunk boundaries are found. Results are in address order. FindNextPatternParallel
+		    returns false if there is no match or the search was cancelled; the FindAll forms return false
+		    if the search was cancelled, leaving a partial result list.
+		*/
+		bool FindNextPatternParallel(uint64_t start, uint64_t end, const BytePattern& pattern, uint64_t& result,
+			const ParallelSearchSettings& settings = ParallelSearchSettings());
+		bool FindAllPatternParallel(uint64_t start, uint64_t end, const BytePattern& pattern,
+			std::vector<uint64_t>& results, const ParallelSearchSettings& settings = ParallelSearchSettings());
+		bool FindAllDataParallel(uint64_t start, uint64_t end, const DataBufferView& data,
+			std::vector<uint64_t>& results, BNFindFlag flags = NoFindFlags,
+			const ParallelSearchSettings& settings = ParallelSearchSettings());
+
+		/*! Scans [start, end) for strings in the encodings selected by settings, using the worker pool
+		    described by parallel. Wide characters are read at offsets aligned to the character size
+		    relative to start. Results are in address order with lengths in bytes. Returns false if the
+		    scan was cancelled.
+		*/
+		bool FindStrings(uint64_t start, uint64_t end, std::vector<BNStringReference>& results,
+			const StringScanSettings& settings = StringScanSettings(),
+			const ParallelSearchSettings& parallel = ParallelSearchSettings());
+		/*! Finds every aligned pointer sized value lying within [start, end) that holds a valid address of
+		    the view, using the view's address size and default endianness. An alignment of zero uses the
+		    address size. The range is scanned in parallel chunks and results are sorted by source
+		    address. Returns false if the scan was cancelled.
+		*/
+		bool FindDataPointers(uint64_t start, uint64_t end, std::vector<DataReference>& results, size_t alignment = 0,
+			const ParallelSearchSettings& settings = ParallelSearchSettings());
+
+		bool FindNextRegex(uint64_t start, uint64_t end, BinaryRegex* regex, RegexMatch& result);
+		bool FindAllRegex(uint64_t start, uint64_t end, BinaryRegex* regex,
+			const std::function<bool(const RegexMatch& match)>& callback);
 	};
 
 	class BinaryData: public BinaryView
@@ -922,6 +1465,375 @@ namespace BinaryNinja
 		BinaryData(FileMetadata* file, FileAccessor* accessor);
 	};
 
+	/*! StringIndex keeps an address ordered copy of a view's string list. It loads the list once and then
+	    stays current through the string found and removed notifications, so lookups, counts and paging
+	    cost O(log n) plus the size of the result instead of a full copy of the list. Notifications are
+	    collected and merged into the sorted list by the next query. Strings are keyed by start address
+	    and type, and range queries select strings by start address. All methods are safe to call while
+	    analysis is adding or removing strings.
+	*/
+	class StringIndex: public BinaryDataNotification
+	{
+		typedef std::pair<uint64_t, BNStringType> Key;
+
+		struct PendingString
+		{
+			bool present;
+			size_t length;
+		};
+
+		Ref<BinaryView> m_view;
+		mutable std::mutex m_mutex;
+		mutable std::vector<BNStringReference> m_strings;
+		mutable std::map<Key, PendingString> m_pending;
+		bool m_loading;
+
+		void ApplyPending() const;
+		std::vector<BNStringReference>::const_iterator LowerBound(uint64_t addr) const;
+
+		StringIndex(const StringIndex&) = delete;
+		StringIndex& operator=(const StringIndex&) = delete;
+
+	public:
+		StringIndex(BinaryView* view);
+		virtual ~StringIndex();
+
+		/*! Discards the index and loads the view's current string list again. */
+		void Refresh();
+
+		size_t GetCount() const;
+		size_t GetCount(uint64_t start, uint64_t len) const;
+		bool GetStringAt(uint64_t addr, BNStringReference& result) const;
+		bool GetNextString(uint64_t addr, BNStringReference& result) const;
+
+		std::vector<BNStringReference> GetStrings(uint64_t start, uint64_t len) const;
+		/*! Returns up to maxCount strings starting at or after addr. To fetch the next page, pass one past
+		    the start of the last string returned.
+		*/
+		std::vector<BNStringReference> GetPage(uint64_t addr, size_t maxCount) const;
+		/*! Calls callback for each string starting in [start, start + len), in address order, until it
+		    returns false. The index is locked while iterating, so the callback must not call back
+		    into this index.
+		*/
+		void ForEachString(uint64_t start, uint64_t len,
+			const std::function<bool(const BNStringReference& str)>& callback) const;
+
+		virtual void OnStringFound(BinaryView* data, BNStringType type, uint64_t offset, size_t len) override;
+		virtual void OnStringRemoved(BinaryView* data, BNStringType type, uint64_t offset, size_t len) override;
+	};
+
+	/*! Lightweight description of a symbol returned by SymbolCursor. The name pointers refer to storage
+	    owned by the cursor and remain valid until the next page is loaded. They are null when the cursor
+	    was told not to fetch names.
+	*/
+	struct SymbolInfo
+	{
+		BNSymbolType type;
+		uint64_t address;
+		bool autoDefined;
+		const char* shortName;
+		const char* fullName;
+		const char* rawName;
+	};
+
+	/*! SymbolCursor walks the symbols of a view in address order, one page at a time, without creating a
+	    Symbol object for each of them. Symbols are fetched from the core in address windows whose size
+	    adapts to the symbol density, so each window holds roughly a page worth of symbols. Symbols
+	    defined while the cursor is active are picked up if they lie after the current position.
+	*/
+	class SymbolCursor
+	{
+		struct SymbolList
+		{
+			BNSymbol** symbols;
+			size_t count;
+		};
+
+		Ref<BinaryView> m_view;
+		uint64_t m_start, m_last, m_next;
+		bool m_empty, m_done;
+		uint64_t m_window;
+		size_t m_pageSize;
+		bool m_filterType;
+		BNSymbolType m_type;
+		bool m_includeNames;
+
+		std::vector<SymbolList> m_lists;
+		size_t m_listIndex, m_listOffset;
+		std::vector<SymbolInfo> m_page;
+		std::vector<BNSymbol*> m_pageSymbols;
+		std::vector<char> m_names;
+
+		SymbolCursor(const SymbolCursor&) = delete;
+		SymbolCursor& operator=(const SymbolCursor&) = delete;
+
+		void ReleaseConsumedLists();
+		void FreeLists();
+		bool FetchWindow();
+
+	public:
+		/*! Creates a cursor over all symbols of the view, including those outside its mapped range. */
+		SymbolCursor(BinaryView* view, size_t pageSize = 1024);
+		/*! Creates a cursor over the symbols in [start, end). */
+		SymbolCursor(BinaryView* view, uint64_t start, uint64_t end, size_t pageSize = 1024);
+		~SymbolCursor();
+
+		/*! Only return symbols of the given type. Takes effect from the next page, including for symbols
+		    that were already fetched. */
+		void SetTypeFilter(BNSymbolType type);
+		void ClearTypeFilter();
+		/*! Controls whether names are fetched. Skipping them avoids three string copies per symbol. */
+		void SetIncludeNames(bool include);
+
+		/*! Repositions the cursor so that the next page starts at the first symbol at or after addr. */
+		void Seek(uint64_t addr);
+
+		/*! Loads the next page of up to the page size symbols. Returns false once no symbols remain. */
+		bool Next();
+		const std::vector<SymbolInfo>& GetPage() const { return m_page; }
+		/*! Creates a Symbol object for an entry of the current page. */
+		Ref<Symbol> GetSymbol(size_t index) const;
+	};
+
+	/*! A basic block range in a CodeRangeIndex. The function and block objects are owned by the index. */
+	struct CodeRange
+	{
+		uint64_t start, end;
+		Function* function;
+		BasicBlock* block;
+	};
+
+	/*! CodeRangeIndex maps addresses to the basic blocks, and so the functions, that contain them. Block
+	    ranges are kept in a flat array sorted by start address that is also laid out as an implicit
+	    interval tree, with the largest end address of each subtree alongside. Point lookups visit a
+	    logarithmic number of ranges plus the matches, even when large blocks span many small ones, and
+	    do not allocate. Matches are not reported in any particular order. The index is loaded once and
+	    then follows the function added, removed and updated notifications. Changed functions are only
+	    refetched on the next lookup, and only their ranges are replaced, so a burst of updates during
+	    analysis costs a single merge.
+
+	    Pointers in the returned ranges remain valid until the next lookup or Refresh, which may rebuild
+	    the index.
+	*/
+	class CodeRangeIndex: public BinaryDataNotification
+	{
+		struct FunctionBlocks
+		{
+			Ref<Function> function;
+			std::vector<Ref<BasicBlock>> blocks;
+		};
+
+		struct PendingUpdate
+		{
+			Ref<Function> function;
+			bool removed;
+		};
+
+		Ref<BinaryView> m_view;
+		std::mutex m_mutex;
+		std::map<BNFunction*, FunctionBlocks> m_functions;
+		std::vector<CodeRange> m_ranges;
+		std::vector<uint64_t> m_maxEnd;
+		size_t m_rootLevel;
+		bool m_rebuild;
+
+		std::mutex m_pendingMutex;
+		std::map<BNFunction*, PendingUpdate> m_pending;
+
+		CodeRangeIndex(const CodeRangeIndex&) = delete;
+		CodeRangeIndex& operator=(const CodeRangeIndex&) = delete;
+
+		static FunctionBlocks GetFunctionBlocks(Function* func);
+		static void AddRanges(const FunctionBlocks& blocks, std::vector<CodeRange>& ranges);
+		void AddPendingUpdate(Function* func, bool removed);
+		void Update();
+		void UpdateMaxEnd(size_t first);
+
+	public:
+		CodeRangeIndex(BinaryView* view);
+		virtual ~CodeRangeIndex();
+
+		/*! Discards the index and loads the view's current function list again. */
+		void Refresh();
+
+		size_t GetFunctionCount();
+		size_t GetBlockCount();
+
+		/*! Writes up to maxCount ranges containing addr to results and returns the total number of ranges
+		    containing addr, which may be larger than maxCount.
+		*/
+		size_t GetRangesForAddress(uint64_t addr, CodeRange* results, size_t maxCount);
+		/*! Calls callback for each range containing addr until it returns false. The index is locked
+		    while iterating, so the callback must not call back into this index.
+		*/
+		void ForEachRangeForAddress(uint64_t addr, const std::function<bool(const CodeRange& range)>& callback);
+		bool IsCodeAddress(uint64_t addr);
+
+		virtual void OnAnalysisFunctionAdded(BinaryView* view, Function* func) override;
+		virtual void OnAnalysisFunctionRemoved(BinaryView* view, Function* func) override;
+		virtual void OnAnalysisFunctionUpdated(BinaryView* view, Function* func) override;
+	};
+
+	/*! A direct call recorded by CodeReferenceIndex. function is the start of the calling function. */
+	struct CodeReference
+	{
+		uint64_t target;
+		uint64_t source;
+		uint64_t function;
+	};
+
+	/*! CodeReferenceIndex is a persistent reverse index from call targets to the instructions calling
+	    them, for questions such as the callers of every function. The core only answers references one
+	    target at a time, so the index decodes the instructions of each function's basic blocks and
+	    records their direct call destinations. It holds a subset of the references the core reports:
+	    jumps, including tail calls, and references made through data, such as pointers loaded by an
+	    instruction, are not included. Use BinaryView::GetCodeReferences for those.
+
+	    The references of each function are kept separately, sorted the same way as the reverse array.
+	    Changes are applied on the next query after functions are added, removed or updated, using the
+	    same deferred scheme as CodeRangeIndex. Only the changed functions are decoded again, and their
+	    references are merged into the reverse array.
+	*/
+	class CodeReferenceIndex: public BinaryDataNotification
+	{
+		struct FunctionReferences
+		{
+			Ref<Function> function;
+			std::vector<CodeReference> refs;
+		};
+
+		struct PendingUpdate
+		{
+			Ref<Function> function;
+			bool removed;
+		};
+
+		Ref<BinaryView> m_view;
+		std::mutex m_mutex;
+		std::map<BNFunction*, FunctionReferences> m_functions;
+		std::vector<CodeReference> m_refs;
+		bool m_rebuild;
+
+		std::mutex m_pendingMutex;
+		std::map<BNFunction*, PendingUpdate> m_pending;
+
+		CodeReferenceIndex(const CodeReferenceIndex&) = delete;
+		CodeReferenceIndex& operator=(const CodeReferenceIndex&) = delete;
+
+		FunctionReferences GetFunctionReferences(Function* func);
+		void AddPendingUpdate(Function* func, bool removed);
+		void Update();
+
+	public:
+		CodeReferenceIndex(BinaryView* view);
+		virtual ~CodeReferenceIndex();
+
+		/*! Discards the index and decodes every function of the view again. */
+		void Refresh();
+
+		size_t GetReferenceCount();
+		size_t GetReferenceCount(uint64_t target);
+		/*! Calls callback for each reference to target, in source address order, until it returns false.
+		    The index is locked while iterating, so the callback must not call back into this index.
+		*/
+		void ForEachReference(uint64_t target, const std::function<bool(const CodeReference& ref)>& callback);
+		/*! Looks up the calls to each of targets. The result uses the same table layout as
+		    BinaryView::GetCodeReferences, but only holds the direct calls recorded by this index.
+		*/
+		void GetReferences(const std::vector<uint64_t>& targets, CodeReferenceTable& result);
+
+		virtual void OnAnalysisFunctionAdded(BinaryView* view, Function* func) override;
+		virtual void OnAnalysisFunctionRemoved(BinaryView* view, Function* func) override;
+		virtual void OnAnalysisFunctionUpdated(BinaryView* view, Function* func) override;
+	};
+
+	/*! DataReferenceIndex records the pointers stored in a view's data, as found by
+	    BinaryView::FindDataPointers, and answers which locations point into an address range and which
+	    pointers lie in one. It is built by one parallel scan and then kept current through the data
+	    written, inserted and removed notifications, which only rescan the bytes around the change and
+	    move the pointers after an insertion or removal. Pointers rejected before an insertion or removal
+	    are not reconsidered, so call Refresh after large layout changes. The array sorted by target is
+	    rebuilt lazily on the next query by target after a change.
+	*/
+	class DataReferenceIndex: public BinaryDataNotification
+	{
+		Ref<BinaryView> m_view;
+		std::mutex m_mutex;
+		size_t m_pointerSize, m_alignment;
+		ParallelSearchSettings m_settings;
+		std::vector<DataReference> m_bySource;
+		std::vector<DataReference> m_byTarget;
+		bool m_targetsDirty;
+
+		DataReferenceIndex(const DataReferenceIndex&) = delete;
+		DataReferenceIndex& operator=(const DataReferenceIndex&) = delete;
+
+		void Rescan(uint64_t start, uint64_t end);
+		void ShiftSources(uint64_t offset, uint64_t len, bool inserted);
+		void UpdateTargets();
+
+	public:
+		DataReferenceIndex(BinaryView* view, size_t alignment = 0,
+			const ParallelSearchSettings& settings = ParallelSearchSettings());
+		virtual ~DataReferenceIndex();
+
+		/*! Discards the index and scans the whole view again. */
+		void Refresh();
+
+		size_t GetCount();
+		/*! Returns the pointers whose target lies in [start, start + len), sorted by target. */
+		std::vector<DataReference> GetReferencesTo(uint64_t start, uint64_t len);
+		/*! Returns the pointers stored in [start, start + len), sorted by source. */
+		std::vector<DataReference> GetReferencesFrom(uint64_t start, uint64_t len);
+		/*! Calls callback for each pointer whose target lies in [start, start + len) until it returns false.
+		    The index is locked while iterating, so the callback must not call back into this index.
+		*/
+		void ForEachReferenceTo(uint64_t start, uint64_t len,
+			const std::function<bool(const DataReference& ref)>& callback);
+
+		virtual void OnBinaryDataWritten(BinaryView* view, uint64_t offset, size_t len) override;
+		virtual void OnBinaryDataInserted(BinaryView* view, uint64_t offset, size_t len) override;
+		virtual void OnBinaryDataRemoved(BinaryView* view, uint64_t offset, uint64_t len) override;
+	};
+
+	/*! DataVariableList is a snapshot of a view's data variables kept in the array returned by the core,
+	    sorted by address. Variables are addressed by index, so a range query returns a pair of indices
+	    and iterating is a loop over them. Type objects are only created when a variable's type is
+	    requested, and variables sharing the same core type object share one Type object.
+	*/
+	class DataVariableList
+	{
+		BNDataVariable* m_vars;
+		size_t m_count;
+		mutable std::mutex m_typeMutex;
+		mutable std::map<BNType*, Ref<Type>> m_types;
+
+		DataVariableList(const DataVariableList&) = delete;
+		DataVariableList& operator=(const DataVariableList&) = delete;
+
+	public:
+		DataVariableList(BinaryView* view);
+		~DataVariableList();
+
+		size_t GetCount() const { return m_count; }
+		uint64_t GetAddress(size_t i) const { return m_vars[i].address; }
+		bool IsAutoDiscovered(size_t i) const { return m_vars[i].autoDiscovered; }
+		Ref<Type> GetType(size_t i) const;
+		DataVariable GetDataVariable(size_t i) const;
+
+		/*! Returns the index of the first variable at or after addr, or GetCount() if there is none. */
+		size_t GetIndexAtOrAfter(uint64_t addr) const;
+		/*! Looks up the variable at exactly addr. */
+		bool GetIndexAt(uint64_t addr, size_t& index) const;
+		/*! Returns the indices [first, second) of the variables in [start, start + len). */
+		std::pair<size_t, size_t> GetRange(uint64_t start, uint64_t len) const;
+		/*! Calls callback for each variable in [start, start + len), in address order, until it returns
+		    false.
+		*/
+		void ForEachDataVariable(uint64_t start, uint64_t len,
+			const std::function<bool(const DataVariable& var)>& callback) const;
+	};
+
 	class Platform;
 
 	class BinaryViewType: public StaticCoreRefCountObject<BNBinaryViewType>
@@ -975,10 +1887,68 @@ namespace BinaryNinja
 		virtual const char* what() const NOEXCEPT { return "read out of bounds"; }
 	};
 
+	struct RecordField
+	{
+		size_t offset; //!< Offset of the field within each record
+		size_t size; //!< Size of the field in the data (1, 2, 4 or 8)
+		size_t destOffset; //!< Offset of the destination member within the output structure
+		size_t destSize; //!< Size of the destination member (1, 2, 4 or 8)
+		BNEndianness endian;
+		bool isSigned; //!< Sign extend when the destination is wider than the field
+	};
+
+	/*! RecordLayout describes a packed on-disk record (e.g. an ELF relocation or symbol entry) and how each
+	    field maps onto a member of a native structure, so BinaryReader::ReadRecords can decode whole tables
+	    with a single read.
+	*/
+	class RecordLayout
+	{
+		size_t m_recordSize;
+		BNEndianness m_endian;
+		std::vector<RecordField> m_fields;
+
+	public:
+		RecordLayout(size_t recordSize, BNEndianness endian = LittleEndian);
+
+		RecordLayout& AddField(size_t offset, size_t size, size_t destOffset, size_t destSize, bool isSigned = false);
+		RecordLayout& AddField(size_t offset, size_t size, size_t destOffset, size_t destSize, BNEndianness endian,
+			bool isSigned = false);
+
+		size_t GetRecordSize() const { return m_recordSize; }
+		BNEndianness GetEndianness() const { return m_endian; }
+		const std::vector<RecordField>& GetFields() const { return m_fields; }
+		bool IsValid() const;
+	};
+
+	/*! BinaryReader reads integers and byte ranges from a BinaryView at a movable offset.
+
+	    By default every read is forwarded to the core. When a buffer size is set with SetBufferSize, the
+	    reader instead fetches blocks of that size through BinaryView::Read and serves small reads from its
+	    local copy. Buffered data is not refreshed when the view is modified; call InvalidateBuffer after
+	    writing to the underlying view.
+	*/
 	class BinaryReader
 	{
 		Ref<BinaryView> m_view;
 		BNBinaryReader* m_stream;
+		BNEndianness m_endian;
+
+		std::vector<uint8_t> m_buffer;
+		size_t m_bufferSize;
+		uint64_t m_bufferStart;
+		size_t m_bufferLength;
+		uint64_t m_offset;
+
+		bool m_stickyErrors;
+		bool m_error;
+		bool m_skipReads;
+
+		bool ReadBuffered(void* dest, size_t len);
+		size_t PeekData(uint64_t offset, size_t minLength, uint8_t* scratch, size_t scratchSize, const uint8_t*& data);
+		bool RecordReadFailure();
+		bool CheckReadLength(size_t count, size_t elementSize);
+		void ReadFailed();
+		bool TryReadLEB128(uint64_t& result, size_t& len);
 
 	public:
 		BinaryReader(BinaryView* data, BNEndianness endian = LittleEndian);
@@ -987,6 +1957,27 @@ namespace BinaryNinja
 		BNEndianness GetEndianness() const;
 		void SetEndianness(BNEndianness endian);
 
+		/*! Enables buffered reads using blocks of the given size, or disables buffering when size is zero.
+
+		    \param size number of bytes fetched from the view per block (e.g. 0x10000)
+		*/
+		void SetBufferSize(size_t size);
+		size_t GetBufferSize() const { return m_bufferSize; }
+		bool IsBuffered() const { return m_bufferSize != 0; }
+		void InvalidateBuffer();
+
+		BinaryView* GetView() const { return m_view; }
+
+		/*! In sticky error mode, a failed read does not throw ReadException. The failing read and every read
+		    after it return zero (TryRead* methods return false) until ClearError is called, so a parse can
+		    be validated with a single call to Ok at the end.
+		*/
+		void SetStickyErrorMode(bool sticky);
+		bool IsStickyErrorMode() const { return m_stickyErrors; }
+		bool Ok() const { return !m_error; }
+		bool HasError() const { return m_error; }
+		void ClearError();
+
 		void Read(void* dest, size_t len);
 		DataBuffer Read(size_t len);
 		std::string ReadString(size_t len);
@@ -1015,6 +2006,154 @@ namespace BinaryNinja
 		bool TryReadBE32(uint32_t& result);
 		bool TryReadBE64(uint64_t& result);
 
+		/*! Reads a NUL terminated string. The terminator is consumed but not included in the result, and
+		    the read fails if no terminator is found within maxLength bytes.
+		*/
+		std::string ReadCString(size_t maxLength = (size_t)-1);
+		bool TryReadCString(std::string& dest, size_t maxLength = (size_t)-1);
+
+		/*! Reads a NUL terminated UTF-16 string in the reader's byte order and returns it as UTF-8.
+		    maxLength is in 16-bit code units and does not include the terminator.
+		*/
+		std::string ReadUTF16String(size_t maxLength = (size_t)-1);
+		bool TryReadUTF16String(std::string& dest, size_t maxLength = (size_t)-1);
+
+		uint64_t ReadULEB128();
+		int64_t ReadSLEB128();
+		bool TryReadULEB128(uint64_t& result);
+		bool TryReadSLEB128(int64_t& result);
+
+		/*! Reads count consecutive integers of elementSize bytes each (1, 2, 4 or 8) with a single read,
+		    converting them from the given endianness to host byte order. The vector forms check the
+		    count against the end of the view before allocating and return an empty vector when it
+		    does not fit.
+		*/
+		bool TryReadArray(void* dest, size_t count, size_t elementSize, BNEndianness endian);
+
+		template <typename T>
+		bool TryReadArray(T* dest, size_t count)
+		{
+			static_assert(std::is_integral<T>::value, "array elements must be integers");
+			return TryReadArray(dest, count, sizeof(T), m_endian);
+		}
+
+		template <typename T>
+		bool TryReadLEArray(T* dest, size_t count)
+		{
+			static_assert(std::is_integral<T>::value, "array elements must be integers");
+			return TryReadArray(dest, count, sizeof(T), LittleEndian);
+		}
+
+		template <typename T>
+		bool TryReadBEArray(T* dest, size_t count)
+		{
+			static_assert(std::is_integral<T>::value, "array elements must be integers");
+			return TryReadArray(dest, count, sizeof(T), BigEndian);
+		}
+
+		template <typename T>
+		bool TryReadArray(std::vector<T>& dest, size_t count)
+		{
+			if (!CheckReadLength(count, sizeof(T)))
+			{
+				dest.clear();
+				return false;
+			}
+			dest.resize(count);
+			return TryReadArray(dest.data(), count);
+		}
+
+		template <typename T>
+		bool TryReadLEArray(std::vector<T>& dest, size_t count)
+		{
+			if (!CheckReadLength(count, sizeof(T)))
+			{
+				dest.clear();
+				return false;
+			}
+			dest.resize(count);
+			return TryReadLEArray(dest.data(), count);
+		}
+
+		template <typename T>
+		bool TryReadBEArray(std::vector<T>& dest, size_t count)
+		{
+			if (!CheckReadLength(count, sizeof(T)))
+			{
+				dest.clear();
+				return false;
+			}
+			dest.resize(count);
+			return TryReadBEArray(dest.data(), count);
+		}
+
+		template <typename T>
+		std::vector<T> ReadArray(size_t count)
+		{
+			std::vector<T> result;
+			if (!TryReadArray(result, count))
+			{
+				ReadFailed();
+				result.assign(result.size(), T());
+			}
+			return result;
+		}
+
+		template <typename T>
+		std::vector<T> ReadLEArray(size_t count)
+		{
+			std::vector<T> result;
+			if (!TryReadLEArray(result, count))
+			{
+				ReadFailed();
+				result.assign(result.size(), T());
+			}
+			return result;
+		}
+
+		template <typename T>
+		std::vector<T> ReadBEArray(size_t count)
+		{
+			std::vector<T> result;
+			if (!TryReadBEArray(result, count))
+			{
+				ReadFailed();
+				result.assign(result.size(), T());
+			}
+			return result;
+		}
+
+		/*! Reads count consecutive records described by layout and decodes each into a structure at
+		    dest + (index * destStride). Structure bytes not covered by a field are left untouched.
+		    Counts reaching past the end of the view fail before anything is read, and the vector
+		    forms then return an empty vector instead of count zeroed elements.
+		*/
+		bool TryReadRecords(const RecordLayout& layout, void* dest, size_t count, size_t destStride);
+
+		template <typename T>
+		bool TryReadRecords(const RecordLayout& layout, std::vector<T>& dest, size_t count)
+		{
+			if (!CheckReadLength(count, layout.GetRecordSize()))
+			{
+				dest.clear();
+				return false;
+			}
+			dest.resize(count);
+			return TryReadRecords(layout, dest.data(), count, sizeof(T));
+		}
+
+		template <typename T>
+		std::vector<T> ReadRecords(const RecordLayout& layout, size_t count)
+		{
+			std::vector<T> result;
+			if (!TryReadRecords(layout, result, count))
+			{
+				ReadFailed();
+				result.assign(result.size(), T());
+			}
+			return result;
+		}
+
 		uint64_t GetOffset() const;
 		void Seek(uint64_t offset);
 		void SeekRelative(int64_t offset);
@@ -1022,6 +2161,237 @@ namespace BinaryNinja
 		bool IsEndOfFile() const;
 	};
 
+	template <BNEndianness Endian>
+	struct EndianDecoder;
+
+	template <>
+	struct EndianDecoder<LittleEndian>
+	{
+		static uint16_t Decode16(const uint8_t* data)
+		{
+			return (uint16_t)((uint16_t)data[0] | ((uint16_t)data[1] << 8));
+		}
+
+		static uint32_t Decode32(const uint8_t* data)
+		{
+			return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+		}
+
+		static uint64_t Decode64(const uint8_t* data)
+		{
+			return (uint64_t)Decode32(data) | ((uint64_t)Decode32(data + 4) << 32);
+		}
+	};
+
+	template <>
+	struct EndianDecoder<BigEndian>
+	{
+		static uint16_t Decode16(const uint8_t* data)
+		{
+			return (uint16_t)(((uint16_t)data[0] << 8) | (uint16_t)data[1]);
+		}
+
+		static uint32_t Decode32(const uint8_t* data)
+		{
+			return ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | (uint32_t)data[3];
+		}
+
+		static uint64_t Decode64(const uint8_t* data)
+		{
+			return ((uint64_t)Decode32(data) << 32) | (uint64_t)Decode32(data + 4);
+		}
+	};
+
+	/*! BasicBinaryReader is a header-only reader whose byte order is fixed at compile time, so integer reads
+	    decode without any endianness checks or core calls. It reads blocks through BinaryView::Read and uses
+	    the same offsets as BinaryReader, so parsing can move between the two with GetOffset and Seek.
+	    Use LittleEndianBinaryReader or BigEndianBinaryReader rather than naming the template directly.
+	*/
+	template <BNEndianness Endian>
+	class BasicBinaryReader
+	{
+		Ref<BinaryView> m_view;
+		std::vector<uint8_t> m_buffer;
+		uint64_t m_bufferStart;
+		size_t m_bufferLength;
+		uint64_t m_offset;
+
+		const uint8_t* FetchSlow(size_t len)
+		{
+			m_bufferStart = m_offset;
+			m_bufferLength = m_view->Read(&m_buffer[0], m_offset, m_buffer.size());
+			if (len <= m_bufferLength)
+				return &m_buffer[0];
+
+			// The block crossed the end of the data or an unreadable gap; retry with the exact length
+			m_bufferLength = m_view->Read(&m_buffer[0], m_offset, len);
+			if (len <= m_bufferLength)
+				return &m_buffer[0];
+			return nullptr;
+		}
+
+		const uint8_t* Fetch(size_t len)
+		{
+			if ((m_offset >= m_bufferStart) && ((m_offset - m_bufferStart) <= m_bufferLength) &&
+				(len <= (m_bufferLength - (size_t)(m_offset - m_bufferStart))))
+				return &m_buffer[(size_t)(m_offset - m_bufferStart)];
+			return FetchSlow(len);
+		}
+
+	public:
+		BasicBinaryReader(BinaryView* data, uint64_t offset = 0, size_t bufferSize = 0x10000):
+			m_view(data), m_buffer(bufferSize < 16 ? 16 : bufferSize), m_bufferStart(0), m_bufferLength(0),
+			m_offset(offset)
+		{
+		}
+
+		explicit BasicBinaryReader(const BinaryReader& reader, size_t bufferSize = 0x10000):
+			m_view(reader.GetView()), m_buffer(bufferSize < 16 ? 16 : bufferSize), m_bufferStart(0),
+			m_bufferLength(0), m_offset(reader.GetOffset())
+		{
+		}
+
+		BinaryView* GetView() const { return m_view; }
+		static BNEndianness GetEndianness() { return Endian; }
+
+		bool TryRead(void* dest, size_t len)
+		{
+			if (len > m_buffer.size())
+			{
+				if (m_view->Read(dest, m_offset, len) != len)
+					return false;
+				m_offset += len;
+				return true;
+			}
+
+			const uint8_t* data = Fetch(len);
+			if (!data)
+				return false;
+			memcpy(dest, data, len);
+			m_offset += len;
+			return true;
+		}
+
+		bool TryRead8(uint8_t& result)
+		{
+			const uint8_t* data = Fetch(1);
+			if (!data)
+			{
+				result = 0;
+				return false;
+			}
+			result = *data;
+			m_offset += 1;
+			return true;
+		}
+
+		bool TryRead16(uint16_t& result)
+		{
+			const uint8_t* data = Fetch(2);
+			if (!data)
+			{
+				result = 0;
+				return false;
+			}
+			result = EndianDecoder<Endian>::Decode16(data);
+			m_offset += 2;
+			return true;
+		}
+
+		bool TryRead32(uint32_t& result)
+		{
+			const uint8_t* data = Fetch(4);
+			if (!data)
+			{
+				result = 0;
+				return false;
+			}
+			result = EndianDecoder<Endian>::Decode32(data);
+			m_offset += 4;
+			return true;
+		}
+
+		bool TryRead64(uint64_t& result)
+		{
+			const uint8_t* data = Fetch(8);
+			if (!data)
+			{
+				result = 0;
+				return false;
+			}
+			result = EndianDecoder<Endian>::Decode64(data);
+			m_offset += 8;
+			return true;
+		}
+
+		void Read(void* dest, size_t len)
+		{
+			if (!TryRead(dest, len))
+				throw ReadException();
+		}
+
+		DataBuffer Read(size_t len)
+		{
+			DataBuffer result(len);
+			Read(result.GetData(), len);
+			return result;
+		}
+
+		std::string ReadString(size_t len)
+		{
+			std::string result(len, '\0');
+			if (len != 0)
+				Read(&result[0], len);
+			return result;
+		}
+
+		uint8_t Read8()
+		{
+			uint8_t result;
+			if (!TryRead8(result))
+				throw ReadException();
+			return result;
+		}
+
+		uint16_t Read16()
+		{
+			uint16_t result;
+			if (!TryRead16(result))
+				throw ReadException();
+			return result;
+		}
+
+		uint32_t Read32()
+		{
+			uint32_t result;
+			if (!TryRead32(result))
+				throw ReadException();
+			return result;
+		}
+
+		uint64_t Read64()
+		{
+			uint64_t result;
+			if (!TryRead64(result))
+				throw ReadException();
+			return result;
+		}
+
+		uint64_t GetOffset() const { return m_offset; }
+		void Seek(uint64_t offset) { m_offset = offset; }
+		void SeekRelative(int64_t offset) { m_offset += offset; }
+		bool IsEndOfFile() const { return m_offset >= m_view->GetEnd(); }
+
+		void InvalidateBuffer()
+		{
+			m_bufferStart = 0;
+			m_bufferLength = 0;
+		}
+	};
+
+	typedef BasicBinaryReader<LittleEndian> LittleEndianBinaryReader;
+	typedef BasicBinaryReader<BigEndian> BigEndianBinaryReader;
+
 	class WriteException: public std::exception
 	{
 	public:
@@ -1029,10 +2399,32 @@ namespace BinaryNinja
 		virtual const char* what() const NOEXCEPT { return "write out of bounds"; }
 	};
 
+	/*! BinaryWriter writes integers and byte ranges to a BinaryView at a movable offset.
+
+	    In write combining mode (SetWriteCombining), writes are collected in the wrapper and contiguous
+	    ranges are merged. Flush then issues one BinaryView::Write per merged range inside a single undo
+	    action, so notifications and undo entries are produced per range instead of per write. Pending
+	    writes are not visible through the view until they are flushed. Disabling write combining flushes
+	    them and reports a failure the same way Flush does. Call Flush before the writer is destroyed: the
+	    destructor also flushes what remains, but it can only log a failure.
+	*/
 	class BinaryWriter
 	{
 		Ref<BinaryView> m_view;
 		BNBinaryWriter* m_stream;
+		BNEndianness m_endian;
+
+		bool m_stickyErrors;
+		bool m_error;
+		bool m_skipWrites;
+
+		bool m_combining;
+		uint64_t m_offset;
+		std::map<uint64_t, std::vector<uint8_t>> m_pending;
+
+		bool RecordWriteFailure();
+		void WriteFailed();
+		void AddPendingWrite(uint64_t offset, const uint8_t* data, size_t len);
 
 	public:
 		BinaryWriter(BinaryView* data, BNEndianness endian = LittleEndian);
@@ -1041,6 +2433,22 @@ namespace BinaryNinja
 		BNEndianness GetEndianness() const;
 		void SetEndianness(BNEndianness endian);
 
+		/*! In sticky error mode, a failed write does not throw WriteException. The failing write and every
+		    write after it are skipped (TryWrite* methods return false) until ClearError is called, so a
+		    sequence of writes can be validated with a single call to Ok at the end.
+		*/
+		void SetStickyErrorMode(bool sticky);
+		bool IsStickyErrorMode() const { return m_stickyErrors; }
+		bool Ok() const { return !m_error; }
+		bool HasError() const { return m_error; }
+		void ClearError();
+
+		void SetWriteCombining(bool enabled);
+		bool IsWriteCombining() const { return m_combining; }
+		size_t GetPendingRangeCount() const { return m_pending.size(); }
+		void Flush();
+		bool TryFlush();
+
 		void Write(const void* src, size_t len);
 		void Write(const DataBuffer& buf);
 		void Write(const std::string& str);
@@ -18,13 +18,286 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
+#include "simd.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
-BinaryReader::BinaryReader(BinaryView* data, BNEndianness endian): m_view(data)
+static inline BNEndianness GetHostEndianness()
+{
+	const uint16_t value = 1;
+	return (*(const uint8_t*)&value == 1) ? LittleEndian : BigEndian;
+}
+
+
+static inline uint16_t ByteSwap16(uint16_t value)
+{
+	return (uint16_t)((value >> 8) | (value << 8));
+}
+
+
+static inline uint32_t ByteSwap32(uint32_t value)
+{
+	return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24);
+}
+
+
+static inline uint64_t ByteSwap64(uint64_t value)
+{
+	return ((uint64_t)ByteSwap32((uint32_t)value) << 32) | (uint64_t)ByteSwap32((uint32_t)(value >> 32));
+}
+
+
+#ifdef BN_SIMD_X86
+// Builds the pshufb control that reverses each elementSize-byte group within a 16 byte lane
+static void GetByteSwapShuffle(uint8_t* shuffle, size_t elementSize)
+{
+	for (size_t i = 0; i < 16; i++)
+		shuffle[i] = (uint8_t)(((i / elementSize) * elementSize) + (elementSize - 1 - (i % elementSize)));
+}
+
+
+BN_SIMD_TARGET("ssse3")
+static size_t ByteSwapArraySSSE3(uint8_t* data, size_t len, size_t elementSize)
+{
+	uint8_t shuffleBytes[16];
+	GetByteSwapShuffle(shuffleBytes, elementSize);
+	__m128i shuffle = _mm_loadu_si128((const __m128i*)shuffleBytes);
+
+	size_t i = 0;
+	for (; (i + 16) <= len; i += 16)
+	{
+		__m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+		_mm_storeu_si128((__m128i*)(data + i), _mm_shuffle_epi8(value, shuffle));
+	}
+	return i;
+}
+
+
+BN_SIMD_TARGET("avx2")
+static size_t ByteSwapArrayAVX2(uint8_t* data, size_t len, size_t elementSize)
+{
+	uint8_t shuffleBytes[16];
+	GetByteSwapShuffle(shuffleBytes, elementSize);
+	__m256i shuffle = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)shuffleBytes));
+
+	size_t i = 0;
+	for (; (i + 64) <= len; i += 64)
+	{
+		__m256i first = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i second = _mm256_loadu_si256((const __m256i*)(data + i + 32));
+		_mm256_storeu_si256((__m256i*)(data + i), _mm256_shuffle_epi8(first, shuffle));
+		_mm256_storeu_si256((__m256i*)(data + i + 32), _mm256_shuffle_epi8(second, shuffle));
+	}
+	for (; (i + 32) <= len; i += 32)
+	{
+		__m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+		_mm256_storeu_si256((__m256i*)(data + i), _mm256_shuffle_epi8(value, shuffle));
+	}
+	return i;
+}
+#endif
+
+
+static void ByteSwapArray(void* dest, size_t count, size_t elementSize)
+{
+	uint8_t* data = (uint8_t*)dest;
+	size_t len = count * elementSize;
+	size_t i = 0;
+
+#ifdef BN_SIMD_X86
+	// Vector blocks are multiples of every element size, so the scalar loop below
+	// always resumes on an element boundary
+	if (Simd::HasAVX2())
+		i = ByteSwapArrayAVX2(data, len, elementSize);
+	else if (Simd::HasSSSE3())
+		i = ByteSwapArraySSSE3(data, len, elementSize);
+#endif
+
+	switch (elementSize)
+	{
+	case 2:
+		for (; i < len; i += 2)
+		{
+			uint16_t value;
+			memcpy(&value, data + i, sizeof(value));
+			value = ByteSwap16(value);
+			memcpy(data + i, &value, sizeof(value));
+		}
+		break;
+	case 4:
+		for (; i < len; i += 4)
+		{
+			uint32_t value;
+			memcpy(&value, data + i, sizeof(value));
+			value = ByteSwap32(value);
+			memcpy(data + i, &value, sizeof(value));
+		}
+		break;
+	case 8:
+		for (; i < len; i += 8)
+		{
+			uint64_t value;
+			memcpy(&value, data + i, sizeof(value));
+			value = ByteSwap64(value);
+			memcpy(data + i, &value, sizeof(value));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+
+template <typename T, BNEndianness Endian>
+static inline T DecodeField(const uint8_t* data);
+
+template <>
+inline uint8_t DecodeField<uint8_t, LittleEndian>(const uint8_t* data) { return *data; }
+template <>
+inline uint16_t DecodeField<uint16_t, LittleEndian>(const uint8_t* data) { return EndianDecoder<LittleEndian>::Decode16(data); }
+template <>
+inline uint32_t DecodeField<uint32_t, LittleEndian>(const uint8_t* data) { return EndianDecoder<LittleEndian>::Decode32(data); }
+template <>
+inline uint64_t DecodeField<uint64_t, LittleEndian>(const uint8_t* data) { return EndianDecoder<LittleEndian>::Decode64(data); }
+template <>
+inline uint8_t DecodeField<uint8_t, BigEndian>(const uint8_t* data) { return *data; }
+template <>
+inline uint16_t DecodeField<uint16_t, BigEndian>(const uint8_t* data) { return EndianDecoder<BigEndian>::Decode16(data); }
+template <>
+inline uint32_t DecodeField<uint32_t, BigEndian>(const uint8_t* data) { return EndianDecoder<BigEndian>::Decode32(data); }
+template <>
+inline uint64_t DecodeField<uint64_t, BigEndian>(const uint8_t* data) { return EndianDecoder<BigEndian>::Decode64(data); }
+
+
+template <typename Src, typename Dest>
+static inline Dest ExtendField(Src value, bool isSigned)
+{
+	if (isSigned)
+	{
+		typedef typename std::make_signed<Src>::type SignedSrc;
+		typedef typename std::make_signed<Dest>::type SignedDest;
+		return (Dest)(SignedDest)(SignedSrc)value;
+	}
+	return (Dest)value;
+}
+
+
+// Decodes one field across every record. Iterating field by field keeps the width, endianness and
+// destination type fixed for the whole inner loop.
+template <typename Src, BNEndianness Endian, typename Dest>
+static void DecodeFieldColumn(const uint8_t* src, size_t srcStride, uint8_t* dest, size_t destStride, size_t count,
+	bool isSigned)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		Dest value = ExtendField<Src, Dest>(DecodeField<Src, Endian>(src), isSigned);
+		memcpy(dest, &value, sizeof(value));
+		src += srcStride;
+		dest += destStride;
+	}
+}
+
+
+template <typename Src, BNEndianness Endian>
+static void DecodeFieldColumn(const uint8_t* src, size_t srcStride, uint8_t* dest, size_t destStride, size_t count,
+	size_t destSize, bool isSigned)
+{
+	switch (destSize)
+	{
+	case 1:
+		DecodeFieldColumn<Src, Endian, uint8_t>(src, srcStride, dest, destStride, count, isSigned);
+		break;
+	case 2:
+		DecodeFieldColumn<Src, Endian, uint16_t>(src, srcStride, dest, destStride, count, isSigned);
+		break;
+	case 4:
+		DecodeFieldColumn<Src, Endian, uint32_t>(src, srcStride, dest, destStride, count, isSigned);
+		break;
+	default:
+		DecodeFieldColumn<Src, Endian, uint64_t>(src, srcStride, dest, destStride, count, isSigned);
+		break;
+	}
+}
+
+
+template <BNEndianness Endian>
+static void DecodeFieldColumn(const RecordField& field, const uint8_t* src, size_t srcStride, uint8_t* dest,
+	size_t destStride, size_t count)
+{
+	src += field.offset;
+	dest += field.destOffset;
+	switch (field.size)
+	{
+	case 1:
+		DecodeFieldColumn<uint8_t, Endian>(src, srcStride, dest, destStride, count, field.destSize, field.isSigned);
+		break;
+	case 2:
+		DecodeFieldColumn<uint16_t, Endian>(src, srcStride, dest, destStride, count, field.destSize, field.isSigned);
+		break;
+	case 4:
+		DecodeFieldColumn<uint32_t, Endian>(src, srcStride, dest, destStride, count, field.destSize, field.isSigned);
+		break;
+	default:
+		DecodeFieldColumn<uint64_t, Endian>(src, srcStride, dest, destStride, count, field.destSize, field.isSigned);
+		break;
+	}
+}
+
+
+static bool IsValidFieldSize(size_t size)
+{
+	return (size == 1) || (size == 2) || (size == 4) || (size == 8);
+}
+
+
+RecordLayout::RecordLayout(size_t recordSize, BNEndianness endian): m_recordSize(recordSize), m_endian(endian)
+{
+}
+
+
+RecordLayout& RecordLayout::AddField(size_t offset, size_t size, size_t destOffset, size_t destSize, bool isSigned)
+{
+	return AddField(offset, size, destOffset, destSize, m_endian, isSigned);
+}
+
+
+RecordLayout& RecordLayout::AddField(size_t offset, size_t size, size_t destOffset, size_t destSize,
+	BNEndianness endian, bool isSigned)
+{
+	RecordField field;
+	field.offset = offset;
+	field.size = size;
+	field.destOffset = destOffset;
+	field.destSize = destSize;
+	field.endian = endian;
+	field.isSigned = isSigned;
+	m_fields.push_back(field);
+	return *this;
+}
+
+
+bool RecordLayout::IsValid() const
+{
+	if (m_recordSize == 0)
+		return false;
+	for (auto& i : m_fields)
+	{
+		if (!IsValidFieldSize(i.size) || !IsValidFieldSize(i.destSize))
+			return false;
+		if ((i.offset > m_recordSize) || (i.size > (m_recordSize - i.offset)))
+			return false;
+	}
+	return true;
+}
+
+
+BinaryReader::BinaryReader(BinaryView* data, BNEndianness endian): m_view(data), m_endian(endian),
+	m_bufferSize(0), m_bufferStart(0), m_bufferLength(0), m_offset(0), m_stickyErrors(false), m_error(false),
+	m_skipReads(false)
 {
 	m_stream = BNCreateBinaryReader(data->GetObject());
 	BNSetBinaryReaderEndianness(m_stream, endian);
@@ -39,23 +312,112 @@ BinaryReader::~BinaryReader()
 
 BNEndianness BinaryReader::GetEndianness() const
 {
-	return BNGetBinaryReaderEndianness(m_stream);
+	return m_endian;
 }
 
 
 void BinaryReader::SetEndianness(BNEndianness endian)
 {
+	m_endian = endian;
 	BNSetBinaryReaderEndianness(m_stream, endian);
 }
 
 
-void BinaryReader::Read(void* dest, size_t len)
+void BinaryReader::SetBufferSize(size_t size)
+{
+	if (size == m_bufferSize)
+		return;
+
+	// The core reader's position is only kept up to date while unbuffered, so hand the
+	// current offset over whenever the mode changes
+	if (m_bufferSize == 0)
+		m_offset = BNGetReaderPosition(m_stream);
+	else if (size == 0)
+		BNSeekBinaryReader(m_stream, m_offset);
+
+	m_bufferSize = size;
+	m_buffer.resize(size);
+	m_buffer.shrink_to_fit();
+	InvalidateBuffer();
+}
+
+
+void BinaryReader::InvalidateBuffer()
+{
+	m_bufferStart = 0;
+	m_bufferLength = 0;
+}
+
+
+bool BinaryReader::ReadBuffered(void* dest, size_t len)
 {
-	if (!BNReadData(m_stream, dest, len))
+	if ((m_offset >= m_bufferStart) && ((m_offset - m_bufferStart) <= m_bufferLength) &&
+		(len <= (m_bufferLength - (size_t)(m_offset - m_bufferStart))))
+	{
+		memcpy(dest, &m_buffer[(size_t)(m_offset - m_bufferStart)], len);
+		m_offset += len;
+		return true;
+	}
+
+	if (len <= m_bufferSize)
+	{
+		m_bufferStart = m_offset;
+		m_bufferLength = m_view->Read(&m_buffer[0], m_offset, m_bufferSize);
+		if (len <= m_bufferLength)
+		{
+			memcpy(dest, &m_buffer[0], len);
+			m_offset += len;
+			return true;
+		}
+	}
+
+	// Large reads bypass the buffer, and short block fills (end of data or an unreadable gap
+	// inside the block) are retried with the exact length so results match the unbuffered path
+	if (m_view->Read(dest, m_offset, len) != len)
+		return false;
+	m_offset += len;
+	return true;
+}
+
+
+size_t BinaryReader::PeekData(uint64_t offset, size_t minLength, uint8_t* scratch, size_t scratchSize,
+	const uint8_t*& data)
+{
+	if (m_bufferSize >= minLength)
+	{
+		if ((offset < m_bufferStart) || ((offset - m_bufferStart) > m_bufferLength) ||
+			((m_bufferLength - (size_t)(offset - m_bufferStart)) < minLength))
+		{
+			m_bufferStart = offset;
+			m_bufferLength = m_view->Read(&m_buffer[0], offset, m_bufferSize);
+		}
+		size_t pos = (size_t)(offset - m_bufferStart);
+		data = &m_buffer[pos];
+		return m_bufferLength - pos;
+	}
+
+	data = scratch;
+	return m_view->Read(scratch, offset, scratchSize);
+}
+
+
+void BinaryReader::ReadFailed()
+{
+	if (!m_stickyErrors)
 		throw ReadException();
 }
 
 
+void BinaryReader::Read(void* dest, size_t len)
+{
+	if (!TryRead(dest, len))
+	{
+		ReadFailed();
+		memset(dest, 0, len);
+	}
+}
+
+
 DataBuffer BinaryReader::Read(size_t len)
 {
 	DataBuffer result(len);
@@ -66,16 +428,17 @@ DataBuffer BinaryReader::Read(size_t len)
 
 string BinaryReader::ReadString(size_t len)
 {
-	DataBuffer result = Read(len);
-	return string((const char*)result.GetData(), len);
+	string result(len, '\0');
+	Read(&result[0], len);
+	return result;
 }
 
 
 uint8_t BinaryReader::Read8()
 {
 	uint8_t result;
-	if (!BNRead8(m_stream, &result))
-		throw ReadException();
+	if (!TryRead8(result))
+		ReadFailed();
 	return result;
 }
 
@@ -83,8 +446,8 @@ uint8_t BinaryReader::Read8()
 uint16_t BinaryReader::Read16()
 {
 	uint16_t result;
-	if (!BNRead16(m_stream, &result))
-		throw ReadException();
+	if (!TryRead16(result))
+		ReadFailed();
 	return result;
 }
 
@@ -92,8 +455,8 @@ uint16_t BinaryReader::Read16()
 uint32_t BinaryReader::Read32()
 {
 	uint32_t result;
-	if (!BNRead32(m_stream, &result))
-		throw ReadException();
+	if (!TryRead32(result))
+		ReadFailed();
 	return result;
 }
 
@@ -101,8 +464,8 @@ uint32_t BinaryReader::Read32()
 uint64_t BinaryReader::Read64()
 {
 	uint64_t result;
-	if (!BNRead64(m_stream, &result))
-		throw ReadException();
+	if (!TryRead64(result))
+		ReadFailed();
 	return result;
 }
 
@@ -110,8 +473,8 @@ uint64_t BinaryReader::Read64()
 uint16_t BinaryReader::ReadLE16()
 {
 	uint16_t result;
-	if (!BNReadLE16(m_stream, &result))
-		throw ReadException();
+	if (!TryReadLE16(result))
+		ReadFailed();
 	return result;
 }
 
@@ -119,8 +482,8 @@ uint16_t BinaryReader::ReadLE16()
 uint32_t BinaryReader::ReadLE32()
 {
 	uint32_t result;
-	if (!BNReadLE32(m_stream, &result))
-		throw ReadException();
+	if (!TryReadLE32(result))
+		ReadFailed();
 	return result;
 }
 
@@ -128,8 +491,8 @@ uint32_t BinaryReader::ReadLE32()
 uint64_t BinaryReader::ReadLE64()
 {
 	uint64_t result;
-	if (!BNReadLE64(m_stream, &result))
-		throw ReadException();
+	if (!TryReadLE64(result))
+		ReadFailed();
 	return result;
 }
 
@@ -137,8 +500,8 @@ uint64_t BinaryReader::ReadLE64()
 uint16_t BinaryReader::ReadBE16()
 {
 	uint16_t result;
-	if (!BNReadBE16(m_stream, &result))
-		throw ReadException();
+	if (!TryReadBE16(result))
+		ReadFailed();
 	return result;
 }
 
@@ -146,8 +509,8 @@ uint16_t BinaryReader::ReadBE16()
 uint32_t BinaryReader::ReadBE32()
 {
 	uint32_t result;
-	if (!BNReadBE32(m_stream, &result))
-		throw ReadException();
+	if (!TryReadBE32(result))
+		ReadFailed();
 	return result;
 }
 
@@ -155,15 +518,51 @@ uint32_t BinaryReader::ReadBE32()
 uint64_t BinaryReader::ReadBE64()
 {
 	uint64_t result;
-	if (!BNReadBE64(m_stream, &result))
-		throw ReadException();
+	if (!TryReadBE64(result))
+		ReadFailed();
 	return result;
 }
 
 
+bool BinaryReader::RecordReadFailure()
+{
+	m_error = true;
+	m_skipReads = m_stickyErrors;
+	return false;
+}
+
+
+bool BinaryReader::CheckReadLength(size_t count, size_t elementSize)
+{
+	if (m_skipReads)
+		return false;
+	if ((elementSize != 0) && (count > (SIZE_MAX / elementSize)))
+		return RecordReadFailure();
+
+	// Reject counts the view cannot hold before the caller allocates space for them
+	uint64_t offset = GetOffset();
+	uint64_t end = m_view->GetEnd();
+	uint64_t available = (offset < end) ? (end - offset) : 0;
+	if ((uint64_t)(count * elementSize) > available)
+		return RecordReadFailure();
+	return true;
+}
+
+
 bool BinaryReader::TryRead(void* dest, size_t len)
 {
-	return BNReadData(m_stream, dest, len);
+	if (m_skipReads)
+		return false;
+
+	bool ok;
+	if (m_bufferSize)
+		ok = ReadBuffered(dest, len);
+	else
+		ok = BNReadData(m_stream, dest, len);
+
+	if (!ok)
+		return RecordReadFailure();
+	return true;
 }
 
 
@@ -176,93 +575,483 @@ bool BinaryReader::TryRead(DataBuffer& dest, size_t len)
 
 bool BinaryReader::TryReadString(string& dest, size_t len)
 {
-	DataBuffer result(len);
-	if (!TryRead(result.GetData(), len))
+	string result(len, '\0');
+	if (!TryRead(&result[0], len))
 		return false;
-	dest = string((const char*)result.GetData(), len);
+	dest.swap(result);
 	return true;
 }
 
 
 bool BinaryReader::TryRead8(uint8_t& result)
 {
-	return BNRead8(m_stream, &result);
+	if (!TryRead(&result, 1))
+	{
+		result = 0;
+		return false;
+	}
+	return true;
 }
 
 
 bool BinaryReader::TryRead16(uint16_t& result)
 {
-	return BNRead16(m_stream, &result);
+	uint8_t data[2];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = (m_endian == LittleEndian) ? EndianDecoder<LittleEndian>::Decode16(data) :
+		EndianDecoder<BigEndian>::Decode16(data);
+	return true;
 }
 
 
 bool BinaryReader::TryRead32(uint32_t& result)
 {
-	return BNRead32(m_stream, &result);
+	uint8_t data[4];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = (m_endian == LittleEndian) ? EndianDecoder<LittleEndian>::Decode32(data) :
+		EndianDecoder<BigEndian>::Decode32(data);
+	return true;
 }
 
 
 bool BinaryReader::TryRead64(uint64_t& result)
 {
-	return BNRead64(m_stream, &result);
+	uint8_t data[8];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = (m_endian == LittleEndian) ? EndianDecoder<LittleEndian>::Decode64(data) :
+		EndianDecoder<BigEndian>::Decode64(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadLE16(uint16_t& result)
 {
-	return BNReadLE16(m_stream, &result);
+	uint8_t data[2];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = EndianDecoder<LittleEndian>::Decode16(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadLE32(uint32_t& result)
 {
-	return BNReadLE32(m_stream, &result);
+	uint8_t data[4];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = EndianDecoder<LittleEndian>::Decode32(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadLE64(uint64_t& result)
 {
-	return BNReadLE64(m_stream, &result);
+	uint8_t data[8];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = EndianDecoder<LittleEndian>::Decode64(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadBE16(uint16_t& result)
 {
-	return BNReadBE16(m_stream, &result);
+	uint8_t data[2];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = EndianDecoder<BigEndian>::Decode16(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadBE32(uint32_t& result)
 {
-	return BNReadBE32(m_stream, &result);
+	uint8_t data[4];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = EndianDecoder<BigEndian>::Decode32(data);
+	return true;
 }
 
 
 bool BinaryReader::TryReadBE64(uint64_t& result)
 {
-	return BNReadBE64(m_stream, &result);
+	uint8_t data[8];
+	if (!TryRead(data, sizeof(data)))
+	{
+		result = 0;
+		return false;
+	}
+	result = EndianDecoder<BigEndian>::Decode64(data);
+	return true;
+}
+
+
+static void AppendUTF8(string& dest, uint32_t codePoint)
+{
+	if (codePoint < 0x80)
+	{
+		dest += (char)codePoint;
+	}
+	else if (codePoint < 0x800)
+	{
+		dest += (char)(0xc0 | (codePoint >> 6));
+		dest += (char)(0x80 | (codePoint & 0x3f));
+	}
+	else if (codePoint < 0x10000)
+	{
+		dest += (char)(0xe0 | (codePoint >> 12));
+		dest += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+		dest += (char)(0x80 | (codePoint & 0x3f));
+	}
+	else
+	{
+		dest += (char)(0xf0 | (codePoint >> 18));
+		dest += (char)(0x80 | ((codePoint >> 12) & 0x3f));
+		dest += (char)(0x80 | ((codePoint >> 6) & 0x3f));
+		dest += (char)(0x80 | (codePoint & 0x3f));
+	}
+}
+
+
+static string ConvertUTF16ToUTF8(const vector<uint16_t>& units)
+{
+	string result;
+	result.reserve(units.size());
+	for (size_t i = 0; i < units.size(); i++)
+	{
+		uint32_t unit = units[i];
+		if ((unit >= 0xd800) && (unit < 0xdc00) && ((i + 1) < units.size()) &&
+			(units[i + 1] >= 0xdc00) && (units[i + 1] < 0xe000))
+		{
+			AppendUTF8(result, 0x10000 + ((unit - 0xd800) << 10) + (units[i + 1] - 0xdc00));
+			i++;
+		}
+		else if ((unit >= 0xd800) && (unit < 0xe000))
+		{
+			// Unpaired surrogate
+			AppendUTF8(result, 0xfffd);
+		}
+		else
+		{
+			AppendUTF8(result, unit);
+		}
+	}
+	return result;
+}
+
+
+string BinaryReader::ReadCString(size_t maxLength)
+{
+	string result;
+	if (!TryReadCString(result, maxLength))
+		ReadFailed();
+	return result;
+}
+
+
+bool BinaryReader::TryReadCString(string& dest, size_t maxLength)
+{
+	dest.clear();
+	if (m_skipReads)
+		return false;
+
+	uint64_t offset = GetOffset();
+	uint8_t scratch[1024];
+	while (true)
+	{
+		const uint8_t* data;
+		size_t available = PeekData(offset, 1, scratch, sizeof(scratch), data);
+		if (available == 0)
+			break;
+
+		// Allow one byte past maxLength so that a terminator exactly at the limit is accepted
+		size_t remaining = maxLength - dest.size();
+		if (available > remaining)
+			available = remaining + 1;
+
+		size_t len = Simd::FindByte(data, available, 0);
+		dest.append((const char*)data, len);
+		if (len < available)
+		{
+			Seek(offset + len + 1);
+			return true;
+		}
+		if (dest.size() >= maxLength)
+			break;
+		offset += available;
+	}
+
+	dest.clear();
+	return RecordReadFailure();
+}
+
+
+string BinaryReader::ReadUTF16String(size_t maxLength)
+{
+	string result;
+	if (!TryReadUTF16String(result, maxLength))
+		ReadFailed();
+	return result;
+}
+
+
+bool BinaryReader::TryReadUTF16String(string& dest, size_t maxLength)
+{
+	dest.clear();
+	if (m_skipReads)
+		return false;
+
+	uint64_t offset = GetOffset();
+	uint8_t scratch[1024];
+	vector<uint16_t> units;
+	while (true)
+	{
+		const uint8_t* data;
+		size_t available = PeekData(offset, 2, scratch, sizeof(scratch), data) / 2;
+		if (available == 0)
+			break;
+
+		size_t remaining = maxLength - units.size();
+		if (available > remaining)
+			available = remaining + 1;
+
+		size_t len = Simd::FindZero16(data, available);
+		for (size_t i = 0; i < len; i++)
+		{
+			if (m_endian == LittleEndian)
+				units.push_back(EndianDecoder<LittleEndian>::Decode16(data + (i * 2)));
+			else
+				units.push_back(EndianDecoder<BigEndian>::Decode16(data + (i * 2)));
+		}
+		if (len < available)
+		{
+			dest = ConvertUTF16ToUTF8(units);
+			Seek(offset + ((len + 1) * 2));
+			return true;
+		}
+		if (units.size() >= maxLength)
+			break;
+		offset += available * 2;
+	}
+
+	return RecordReadFailure();
+}
+
+
+// Decodes the 7-bit groups of an LEB128 value without a branch per byte. Bytes past the end of
+// the available data are treated as continuation bytes so they can never end the value.
+bool BinaryReader::TryReadLEB128(uint64_t& result, size_t& len)
+{
+	result = 0;
+	len = 0;
+	if (m_skipReads)
+		return false;
+
+	uint64_t offset = GetOffset();
+	uint8_t scratch[10];
+	const uint8_t* data;
+	size_t available = PeekData(offset, sizeof(scratch), scratch, sizeof(scratch), data);
+	if (available > sizeof(scratch))
+		available = sizeof(scratch);
+
+	uint8_t bytes[16];
+	memset(bytes, 0x80, sizeof(bytes));
+	memcpy(bytes, data, available);
+
+	uint64_t word = EndianDecoder<LittleEndian>::Decode64(bytes);
+	uint64_t terminators = ~word & 0x8080808080808080ULL;
+	if (terminators)
+		len = (Simd::CountTrailingZeros64(terminators) / 8) + 1;
+	else if ((bytes[8] & 0x80) == 0)
+		len = 9;
+	else if ((bytes[9] & 0x80) == 0)
+		len = 10;
+	else
+		return RecordReadFailure();
+
+	uint64_t value = word & 0x7f7f7f7f7f7f7f7fULL;
+	if (len < 8)
+		value &= (1ULL << (len * 8)) - 1;
+	value = ((value & 0x7f007f007f007f00ULL) >> 1) | (value & 0x007f007f007f007fULL);
+	value = ((value & 0x3fff00003fff0000ULL) >> 2) | (value & 0x00003fff00003fffULL);
+	value = ((value & 0x0fffffff00000000ULL) >> 4) | (value & 0x000000000fffffffULL);
+	if (len > 8)
+		value |= (uint64_t)(bytes[8] & 0x7f) << 56;
+	if (len > 9)
+		value |= (uint64_t)(bytes[9] & 0x7f) << 63;
+
+	Seek(offset + len);
+	result = value;
+	return true;
+}
+
+
+uint64_t BinaryReader::ReadULEB128()
+{
+	uint64_t result;
+	if (!TryReadULEB128(result))
+		ReadFailed();
+	return result;
+}
+
+
+int64_t BinaryReader::ReadSLEB128()
+{
+	int64_t result;
+	if (!TryReadSLEB128(result))
+		ReadFailed();
+	return result;
+}
+
+
+bool BinaryReader::TryReadULEB128(uint64_t& result)
+{
+	size_t len;
+	return TryReadLEB128(result, len);
+}
+
+
+bool BinaryReader::TryReadSLEB128(int64_t& result)
+{
+	uint64_t value;
+	size_t len;
+	if (!TryReadLEB128(value, len))
+	{
+		result = 0;
+		return false;
+	}
+
+	// Sign extend from the top bit of the last 7-bit group
+	size_t bits = len * 7;
+	if ((bits < 64) && (value & (1ULL << (bits - 1))))
+		value |= ~0ULL << bits;
+	result = (int64_t)value;
+	return true;
+}
+
+
+bool BinaryReader::TryReadArray(void* dest, size_t count, size_t elementSize, BNEndianness endian)
+{
+	if ((elementSize != 1) && (elementSize != 2) && (elementSize != 4) && (elementSize != 8))
+		return RecordReadFailure();
+	if (count > (SIZE_MAX / elementSize))
+		return RecordReadFailure();
+
+	if (!TryRead(dest, count * elementSize))
+		return false;
+	if ((elementSize > 1) && (endian != GetHostEndianness()))
+		ByteSwapArray(dest, count, elementSize);
+	return true;
+}
+
+
+bool BinaryReader::TryReadRecords(const RecordLayout& layout, void* dest, size_t count, size_t destStride)
+{
+	if (!layout.IsValid())
+		return RecordReadFailure();
+	size_t recordSize = layout.GetRecordSize();
+	for (auto& i : layout.GetFields())
+	{
+		if ((i.destOffset > destStride) || (i.destSize > (destStride - i.destOffset)))
+			return RecordReadFailure();
+	}
+	if (!CheckReadLength(count, recordSize))
+		return false;
+
+	// Records are decoded in blocks so the temporary stays small however many are requested
+	size_t blockRecords = max((size_t)0x10000 / recordSize, (size_t)1);
+	vector<uint8_t> data(min(count, blockRecords) * recordSize);
+	for (size_t done = 0; done < count; )
+	{
+		size_t n = min(count - done, blockRecords);
+		if (!TryRead(data.data(), n * recordSize))
+			return false;
+
+		uint8_t* out = (uint8_t*)dest + (done * destStride);
+		for (auto& i : layout.GetFields())
+		{
+			if (i.endian == LittleEndian)
+				DecodeFieldColumn<LittleEndian>(i, data.data(), recordSize, out, destStride, n);
+			else
+				DecodeFieldColumn<BigEndian>(i, data.data(), recordSize, out, destStride, n);
+		}
+		done += n;
+	}
+	return true;
+}
+
+
+void BinaryReader::SetStickyErrorMode(bool sticky)
+{
+	m_stickyErrors = sticky;
+	m_skipReads = sticky && m_error;
+}
+
+
+void BinaryReader::ClearError()
+{
+	m_error = false;
+	m_skipReads = false;
 }
 
 
 uint64_t BinaryReader::GetOffset() const
 {
+	if (m_bufferSize)
+		return m_offset;
 	return BNGetReaderPosition(m_stream);
 }
 
 
 void BinaryReader::Seek(uint64_t offset)
 {
-	BNSeekBinaryReader(m_stream, offset);
+	if (m_bufferSize)
+		m_offset = offset;
+	else
+		BNSeekBinaryReader(m_stream, offset);
 }
 
 
 void BinaryReader::SeekRelative(int64_t offset)
 {
-	BNSeekBinaryReaderRelative(m_stream, offset);
+	if (m_bufferSize)
+		m_offset += offset;
+	else
+		BNSeekBinaryReaderRelative(m_stream, offset);
 }
 
 
 bool BinaryReader::IsEndOfFile() const
 {
+	if (m_bufferSize)
+		return m_offset >= m_view->GetEnd();
 	return BNIsEndOfFile(m_stream);
 }
@@ -0,0 +1,1128 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <map>
+#include <deque>
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+static const size_t RegexUnbounded = (size_t)-1;
+static const size_t RegexMaxRepeat = 1000;
+static const size_t RegexMaxNesting = 256;
+static const size_t RegexMaxNfaStates = 100000;
+static const size_t RegexMaxCachedStates = 4096;
+static const uint32_t RegexUnknownState = 0xffffffff;
+static const uint32_t RegexGroupMark = 0xffffffff;
+static const uint32_t RegexNoGroup = 0xffffffff;
+
+
+struct RegexByteSet
+{
+	uint64_t bits[4];
+
+	RegexByteSet() { bits[0] = bits[1] = bits[2] = bits[3] = 0; }
+	void Add(uint8_t value) { bits[value >> 6] |= (uint64_t)1 << (value & 63); }
+	bool Contains(uint8_t value) const { return (bits[value >> 6] & ((uint64_t)1 << (value & 63))) != 0; }
+
+	void AddRange(uint8_t first, uint8_t last)
+	{
+		for (size_t i = first; i <= last; i++)
+			Add((uint8_t)i);
+	}
+
+	void AddSet(const RegexByteSet& other)
+	{
+		for (size_t i = 0; i < 4; i++)
+			bits[i] |= other.bits[i];
+	}
+
+	void Invert()
+	{
+		for (size_t i = 0; i < 4; i++)
+			bits[i] = ~bits[i];
+	}
+
+	void FoldCase()
+	{
+		for (uint8_t upper = 'A'; upper <= 'Z'; upper++)
+		{
+			uint8_t lower = upper + ('a' - 'A');
+			if (Contains(upper) || Contains(lower))
+			{
+				Add(upper);
+				Add(lower);
+			}
+		}
+	}
+};
+
+
+struct RegexNode
+{
+	enum Type
+	{
+		ByteSetNode,
+		ConcatNode,
+		AlternateNode,
+		RepeatNode,
+		EmptyNode
+	};
+
+	Type type;
+	size_t set;
+	vector<size_t> children;
+	size_t minCount, maxCount;
+};
+
+
+enum RegexNfaStateType
+{
+	NfaConsume,
+	NfaSplit,
+	NfaAccept
+};
+
+
+struct RegexNfaState
+{
+	RegexNfaStateType type;
+	uint32_t set;
+	uint32_t out;
+	uint32_t alt;
+};
+
+
+struct RegexNfa
+{
+	vector<RegexNfaState> states;
+	uint32_t start;
+};
+
+
+namespace BinaryNinja
+{
+	struct BinaryRegexProgram
+	{
+		vector<RegexByteSet> sets;
+		RegexNfa forward;
+		uint8_t byteClasses[256];
+		size_t classCount;
+	};
+}
+
+
+class RegexParser
+{
+	const string& m_pattern;
+	size_t m_pos;
+	size_t m_depth;
+	bool m_caseInsensitive;
+
+	bool AtEnd() const { return m_pos >= m_pattern.size(); }
+	uint8_t Peek() const { return (uint8_t)m_pattern[m_pos]; }
+
+	bool Fail(const string& message)
+	{
+		if (error.empty())
+			error = message + " at offset " + to_string(m_pos);
+		return false;
+	}
+
+	size_t AddNode(RegexNode::Type type)
+	{
+		RegexNode node;
+		node.type = type;
+		node.set = 0;
+		node.minCount = node.maxCount = 0;
+		nodes.push_back(node);
+		return nodes.size() - 1;
+	}
+
+	size_t AddSetNode(RegexByteSet set)
+	{
+		if (m_caseInsensitive)
+			set.FoldCase();
+		size_t node = AddNode(RegexNode::ByteSetNode);
+		nodes[node].set = sets.size();
+		sets.push_back(set);
+		return node;
+	}
+
+	static int HexDigit(uint8_t ch)
+	{
+		if ((ch >= '0') && (ch <= '9'))
+			return ch - '0';
+		if ((ch >= 'a') && (ch <= 'f'))
+			return ch - 'a' + 10;
+		if ((ch >= 'A') && (ch <= 'F'))
+			return ch - 'A' + 10;
+		return -1;
+	}
+
+	// Parses the escape following a backslash. Escapes that stand for a single byte also report it
+	// in value so they can be used as class range endpoints.
+	bool ParseEscape(RegexByteSet& set, bool& single, uint8_t& value)
+	{
+		if (AtEnd())
+			return Fail("incomplete escape");
+		uint8_t ch = Peek();
+		m_pos++;
+		single = true;
+		switch (ch)
+		{
+		case 'x':
+		{
+			if ((m_pos + 2) > m_pattern.size())
+				return Fail("incomplete hex escape");
+			int hi = HexDigit((uint8_t)m_pattern[m_pos]);
+			int lo = HexDigit((uint8_t)m_pattern[m_pos + 1]);
+			if ((hi < 0) || (lo < 0))
+				return Fail("invalid hex escape");
+			m_pos += 2;
+			value = (uint8_t)((hi << 4) | lo);
+			break;
+		}
+		case 'n': value = '\n'; break;
+		case 'r': value = '\r'; break;
+		case 't': value = '\t'; break;
+		case 'f': value = '\f'; break;
+		case 'v': value = '\v'; break;
+		case '0': value = 0; break;
+		case 'd':
+		case 'D':
+		case 'w':
+		case 'W':
+		case 's':
+		case 'S':
+		{
+			RegexByteSet shorthand;
+			uint8_t lower = ch | 0x20;
+			if (lower == 'd')
+			{
+				shorthand.AddRange('0', '9');
+			}
+			else if (lower == 'w')
+			{
+				shorthand.AddRange('0', '9');
+				shorthand.AddRange('A', 'Z');
+				shorthand.AddRange('a', 'z');
+				shorthand.Add('_');
+			}
+			else
+			{
+				shorthand.Add(' ');
+				shorthand.AddRange('\t', '\r');
+			}
+			if (ch != lower)
+				shorthand.Invert();
+			set.AddSet(shorthand);
+			single = false;
+			return true;
+		}
+		default:
+			if (((ch >= '0') && (ch <= '9')) || ((ch >= 'A') && (ch <= 'Z')) || ((ch >= 'a') && (ch <= 'z')))
+				return Fail("unknown escape");
+			value = ch;
+			break;
+		}
+		set.Add(value);
+		return true;
+	}
+
+	bool ParseClassByte(RegexByteSet& set, bool& single, uint8_t& value)
+	{
+		uint8_t ch = Peek();
+		m_pos++;
+		if (ch == '\\')
+			return ParseEscape(set, single, value);
+		single = true;
+		value = ch;
+		set.Add(value);
+		return true;
+	}
+
+	bool ParseClass(size_t& result)
+	{
+		RegexByteSet set;
+		bool negate = false;
+		if (!AtEnd() && (Peek() == '^'))
+		{
+			negate = true;
+			m_pos++;
+		}
+
+		bool first = true;
+		while (true)
+		{
+			if (AtEnd())
+				return Fail("unterminated character class");
+			if ((Peek() == ']') && !first)
+			{
+				m_pos++;
+				break;
+			}
+			first = false;
+
+			RegexByteSet item;
+			bool single;
+			uint8_t low;
+			if (!ParseClassByte(item, single, low))
+				return false;
+			if (single && ((m_pos + 1) < m_pattern.size()) && (Peek() == '-') && (m_pattern[m_pos + 1] != ']'))
+			{
+				m_pos++;
+				uint8_t high;
+				RegexByteSet unused;
+				if (!ParseClassByte(unused, single, high))
+					return false;
+				if (!single || (high < low))
+					return Fail("invalid class range");
+				item.AddRange(low, high);
+			}
+			set.AddSet(item);
+		}
+
+		// Case folding must happen before negation so that [^a] excludes both cases
+		if (m_caseInsensitive)
+			set.FoldCase();
+		if (negate)
+			set.Invert();
+		size_t node = AddNode(RegexNode::ByteSetNode);
+		nodes[node].set = sets.size();
+		sets.push_back(set);
+		result = node;
+		return true;
+	}
+
+	bool ParseAtom(size_t& result)
+	{
+		uint8_t ch = Peek();
+		m_pos++;
+		switch (ch)
+		{
+		case '(':
+		{
+			if (((m_pos + 1) < m_pattern.size()) && (Peek() == '?') && (m_pattern[m_pos + 1] == ':'))
+				m_pos += 2;
+			if (!ParseAlternate(result))
+				return false;
+			if (AtEnd() || (Peek() != ')'))
+				return Fail("missing ')'");
+			m_pos++;
+			return true;
+		}
+		case '[':
+			return ParseClass(result);
+		case '.':
+		{
+			RegexByteSet set;
+			set.Invert();
+			result = AddSetNode(set);
+			return true;
+		}
+		case '\\':
+		{
+			RegexByteSet set;
+			bool single;
+			uint8_t value;
+			if (!ParseEscape(set, single, value))
+				return false;
+			result = AddSetNode(set);
+			return true;
+		}
+		case '^':
+		case '$':
+			m_pos--;
+			return Fail("anchors are not supported");
+		case ')':
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+		case '|':
+			m_pos--;
+			return Fail(string("unexpected '") + (char)ch + "'");
+		default:
+		{
+			RegexByteSet set;
+			set.Add(ch);
+			result = AddSetNode(set);
+			return true;
+		}
+		}
+	}
+
+	bool ParseCount(size_t& result)
+	{
+		size_t digits = 0;
+		result = 0;
+		while (!AtEnd() && (Peek() >= '0') && (Peek() <= '9'))
+		{
+			result = (result * 10) + (Peek() - '0');
+			if (result > RegexMaxRepeat)
+				return Fail("repeat count is too large");
+			m_pos++;
+			digits++;
+		}
+		if (digits == 0)
+			return Fail("expected repeat count");
+		return true;
+	}
+
+	bool ParseRepeat(size_t& result)
+	{
+		if (!ParseAtom(result))
+			return false;
+
+		while (!AtEnd())
+		{
+			size_t minCount, maxCount;
+			uint8_t ch = Peek();
+			if (ch == '*')
+			{
+				minCount = 0;
+				maxCount = RegexUnbounded;
+				m_pos++;
+			}
+			else if (ch == '+')
+			{
+				minCount = 1;
+				maxCount = RegexUnbounded;
+				m_pos++;
+			}
+			else if (ch == '?')
+			{
+				minCount = 0;
+				maxCount = 1;
+				m_pos++;
+			}
+			else if (ch == '{')
+			{
+				m_pos++;
+				if (!ParseCount(minCount))
+					return false;
+				maxCount = minCount;
+				if (!AtEnd() && (Peek() == ','))
+				{
+					m_pos++;
+					maxCount = RegexUnbounded;
+					if (!AtEnd() && (Peek() != '}') && !ParseCount(maxCount))
+						return false;
+				}
+				if (AtEnd() || (Peek() != '}'))
+					return Fail("missing '}'");
+				m_pos++;
+				if (maxCount < minCount)
+					return Fail("invalid repeat range");
+			}
+			else
+			{
+				break;
+			}
+
+			size_t node = AddNode(RegexNode::RepeatNode);
+			nodes[node].children.push_back(result);
+			nodes[node].minCount = minCount;
+			nodes[node].maxCount = maxCount;
+			result = node;
+		}
+		return true;
+	}
+
+	bool ParseConcat(size_t& result)
+	{
+		vector<size_t> children;
+		while (!AtEnd() && (Peek() != '|') && (Peek() != ')'))
+		{
+			size_t child;
+			if (!ParseRepeat(child))
+				return false;
+			children.push_back(child);
+		}
+
+		if (children.empty())
+			result = AddNode(RegexNode::EmptyNode);
+		else if (children.size() == 1)
+			result = children[0];
+		else
+		{
+			result = AddNode(RegexNode::ConcatNode);
+			nodes[result].children = children;
+		}
+		return true;
+	}
+
+	bool ParseAlternate(size_t& result)
+	{
+		if (++m_depth > RegexMaxNesting)
+			return Fail("pattern is nested too deeply");
+
+		vector<size_t> children;
+		while (true)
+		{
+			size_t child;
+			if (!ParseConcat(child))
+				return false;
+			children.push_back(child);
+			if (AtEnd() || (Peek() != '|'))
+				break;
+			m_pos++;
+		}
+
+		if (children.size() == 1)
+			result = children[0];
+		else
+		{
+			result = AddNode(RegexNode::AlternateNode);
+			nodes[result].children = children;
+		}
+		m_depth--;
+		return true;
+	}
+
+public:
+	vector<RegexNode> nodes;
+	vector<RegexByteSet> sets;
+	string error;
+
+	RegexParser(const string& pattern, bool caseInsensitive):
+		m_pattern(pattern), m_pos(0), m_depth(0), m_caseInsensitive(caseInsensitive)
+	{
+	}
+
+	bool Parse(size_t& root)
+	{
+		if (!ParseAlternate(root))
+			return false;
+		if (!AtEnd())
+			return Fail("unexpected ')'");
+		return true;
+	}
+};
+
+
+class RegexNfaBuilder
+{
+	const vector<RegexNode>& m_nodes;
+
+	uint32_t AddState(RegexNfaStateType type, uint32_t set, uint32_t out, uint32_t alt)
+	{
+		RegexNfaState state;
+		state.type = type;
+		state.set = set;
+		state.out = out;
+		state.alt = alt;
+		nfa.states.push_back(state);
+		return (uint32_t)(nfa.states.size() - 1);
+	}
+
+public:
+	RegexNfa nfa;
+	bool tooLarge;
+
+	RegexNfaBuilder(const vector<RegexNode>& nodes): m_nodes(nodes), tooLarge(false)
+	{
+	}
+
+	// Builds the fragment for a node given the state that follows it, and returns its entry state.
+	// Building back to front means every state's successor already exists when it is created.
+	uint32_t Build(size_t index, uint32_t next)
+	{
+		if (nfa.states.size() > RegexMaxNfaStates)
+		{
+			tooLarge = true;
+			return next;
+		}
+
+		const RegexNode& node = m_nodes[index];
+		switch (node.type)
+		{
+		case RegexNode::ByteSetNode:
+			return AddState(NfaConsume, (uint32_t)node.set, next, 0);
+		case RegexNode::ConcatNode:
+			for (size_t i = node.children.size(); i > 0; i--)
+				next = Build(node.children[i - 1], next);
+			return next;
+		case RegexNode::AlternateNode:
+		{
+			uint32_t entry = Build(node.children.back(), next);
+			for (size_t i = node.children.size() - 1; i > 0; i--)
+			{
+				uint32_t branch = Build(node.children[i - 1], next);
+				entry = AddState(NfaSplit, 0, branch, entry);
+			}
+			return entry;
+		}
+		case RegexNode::RepeatNode:
+		{
+			uint32_t entry = next;
+			if (node.maxCount == RegexUnbounded)
+			{
+				uint32_t loop = AddState(NfaSplit, 0, 0, next);
+				uint32_t body = Build(node.children[0], loop);
+				nfa.states[loop].out = body;
+				entry = loop;
+			}
+			else
+			{
+				for (size_t i = node.minCount; i < node.maxCount; i++)
+				{
+					uint32_t body = Build(node.children[0], entry);
+					entry = AddState(NfaSplit, 0, body, next);
+				}
+			}
+			for (size_t i = 0; i < node.minCount; i++)
+				entry = Build(node.children[0], entry);
+			return entry;
+		}
+		default:
+			return next;
+		}
+	}
+};
+
+
+// How the groups of a DFA state carry over to the next state on a transition. survivors lists, in
+// order, the group of the previous state that each group of the next state continues. A fresh group
+// for a candidate starting after the byte is appended when it has any threads of its own. restart
+// marks the common case where every group dies and only the fresh one is left.
+struct RegexStep
+{
+	vector<uint32_t> survivors;
+	uint32_t accepted;
+	bool fresh;
+	bool unchanged;
+	bool restart;
+};
+
+
+// A candidate match being tracked by the searcher, one per DFA group. end is the end of the longest
+// match found for it so far, or zero if it has not matched yet.
+struct RegexCandidate
+{
+	size_t start;
+	size_t end;
+};
+
+
+// A lazily built DFA for unanchored searches. Each DFA state is a list of NFA threads split into
+// groups, one per candidate start position, earliest first. An NFA state held by an earlier group is
+// never added to a later one, since the earlier start takes priority. When a group reaches the
+// accepting state every later group is dropped, because any match it could produce would overlap.
+// A new group is started after every byte, so the search never has to go back over the data.
+class RegexDfa
+{
+	struct State
+	{
+		vector<uint32_t> threads;
+		uint32_t withoutFirst;
+	};
+
+	const BinaryRegexProgram* m_program;
+	const RegexNfa* m_nfa;
+
+	vector<State> m_states;
+	map<vector<uint32_t>, uint32_t> m_stateIds;
+	vector<uint32_t> m_transitions;
+	vector<uint32_t> m_transitionSteps;
+	vector<RegexStep> m_steps;
+	map<vector<uint32_t>, uint32_t> m_stepIds;
+	uint32_t m_start;
+
+	vector<uint32_t> m_visited;
+	uint32_t m_generation;
+	vector<uint32_t> m_stack;
+	vector<uint32_t> m_threads;
+	vector<uint32_t> m_survivors;
+
+	void AddClosure(uint32_t state, vector<uint32_t>& threads, bool& accepted)
+	{
+		m_stack.push_back(state);
+		while (!m_stack.empty())
+		{
+			uint32_t cur = m_stack.back();
+			m_stack.pop_back();
+			if (m_visited[cur] == m_generation)
+				continue;
+			m_visited[cur] = m_generation;
+
+			const RegexNfaState& nfaState = m_nfa->states[cur];
+			if (nfaState.type == NfaConsume)
+				threads.push_back(cur);
+			else if (nfaState.type == NfaAccept)
+				accepted = true;
+			else
+			{
+				m_stack.push_back(nfaState.alt);
+				m_stack.push_back(nfaState.out);
+			}
+		}
+	}
+
+	void NextGeneration()
+	{
+		if (++m_generation == 0)
+		{
+			fill(m_visited.begin(), m_visited.end(), 0);
+			m_generation = 1;
+		}
+	}
+
+	void Flush()
+	{
+		m_states.clear();
+		m_stateIds.clear();
+		m_transitions.clear();
+		m_transitionSteps.clear();
+		m_steps.clear();
+		m_stepIds.clear();
+		m_start = RegexUnknownState;
+	}
+
+	uint32_t AddState(const vector<uint32_t>& threads, bool& flushed)
+	{
+		auto i = m_stateIds.find(threads);
+		if (i != m_stateIds.end())
+			return i->second;
+
+		if (m_states.size() >= RegexMaxCachedStates)
+		{
+			Flush();
+			flushed = true;
+		}
+
+		State state;
+		state.threads = threads;
+		state.withoutFirst = RegexUnknownState;
+		uint32_t id = (uint32_t)m_states.size();
+		m_states.push_back(state);
+		m_stateIds[threads] = id;
+		m_transitions.resize(m_transitions.size() + m_program->classCount, RegexUnknownState);
+		m_transitionSteps.resize(m_transitions.size(), 0);
+		return id;
+	}
+
+	uint32_t AddStep(uint32_t accepted, bool fresh, bool unchanged)
+	{
+		vector<uint32_t> key = m_survivors;
+		key.push_back(accepted);
+		key.push_back(fresh ? 1 : 0);
+		auto i = m_stepIds.find(key);
+		if (i != m_stepIds.end())
+			return i->second;
+
+		RegexStep step;
+		step.survivors = m_survivors;
+		step.accepted = accepted;
+		step.fresh = fresh;
+		step.unchanged = unchanged;
+		step.restart = m_survivors.empty() && (accepted == RegexNoGroup) && fresh;
+		uint32_t id = (uint32_t)m_steps.size();
+		m_steps.push_back(step);
+		m_stepIds[key] = id;
+		return id;
+	}
+
+	uint32_t ComputeNext(uint32_t state, uint8_t value, uint32_t& step)
+	{
+		NextGeneration();
+		m_threads.clear();
+		m_survivors.clear();
+		uint32_t accepted = RegexNoGroup;
+		bool reached = false;
+		uint32_t group = 0;
+		size_t groupBegin = 0;
+		const vector<uint32_t>& threads = m_states[state].threads;
+		for (size_t i = 0; i <= threads.size(); i++)
+		{
+			if ((i < threads.size()) && (threads[i] != RegexGroupMark))
+			{
+				const RegexNfaState& nfaState = m_nfa->states[threads[i]];
+				if (m_program->sets[nfaState.set].Contains(value))
+					AddClosure(nfaState.out, m_threads, reached);
+				continue;
+			}
+
+			if (m_threads.size() > groupBegin)
+			{
+				m_survivors.push_back(group);
+				m_threads.push_back(RegexGroupMark);
+				groupBegin = m_threads.size();
+			}
+			if (reached)
+			{
+				accepted = group;
+				break;
+			}
+			group++;
+		}
+
+		bool unused = false;
+		AddClosure(m_nfa->start, m_threads, unused);
+		bool fresh = m_threads.size() > groupBegin;
+		if (!fresh && !m_threads.empty())
+			m_threads.pop_back();
+		bool unchanged = (accepted == RegexNoGroup) && !fresh && (m_survivors.size() == group);
+
+		bool flushed = false;
+		uint32_t next = AddState(m_threads, flushed);
+		step = AddStep(accepted, fresh, unchanged);
+		if (!flushed)
+		{
+			size_t index = ((size_t)state * m_program->classCount) + m_program->byteClasses[value];
+			m_transitions[index] = next;
+			m_transitionSteps[index] = step;
+		}
+		return next;
+	}
+
+public:
+	RegexDfa(const BinaryRegexProgram* program, const RegexNfa* nfa):
+		m_program(program), m_nfa(nfa), m_start(RegexUnknownState), m_visited(nfa->states.size(), 0), m_generation(0)
+	{
+	}
+
+	uint32_t Start()
+	{
+		if (m_start == RegexUnknownState)
+		{
+			NextGeneration();
+			m_threads.clear();
+			bool accepted = false;
+			AddClosure(m_nfa->start, m_threads, accepted);
+			bool flushed = false;
+			m_start = AddState(m_threads, flushed);
+		}
+		return m_start;
+	}
+
+	uint32_t Next(uint32_t state, uint8_t value, uint32_t& step)
+	{
+		size_t index = ((size_t)state * m_program->classCount) + m_program->byteClasses[value];
+		uint32_t next = m_transitions[index];
+		if (next == RegexUnknownState)
+			return ComputeNext(state, value, step);
+		step = m_transitionSteps[index];
+		return next;
+	}
+
+	// Returns the state with its first group removed. If that was the only group, a new candidate is
+	// started in its place.
+	uint32_t WithoutFirstGroup(uint32_t state)
+	{
+		uint32_t result = m_states[state].withoutFirst;
+		if (result != RegexUnknownState)
+			return result;
+
+		const vector<uint32_t>& threads = m_states[state].threads;
+		auto mark = find(threads.begin(), threads.end(), RegexGroupMark);
+		if (mark == threads.end())
+			return Start();
+		m_threads.assign(mark + 1, threads.end());
+		bool flushed = false;
+		result = AddState(m_threads, flushed);
+		if (!flushed)
+			m_states[state].withoutFirst = result;
+		return result;
+	}
+
+	const RegexStep& GetStep(uint32_t step) const { return m_steps[step]; }
+};
+
+
+// Finds leftmost-longest matches in a single pass. Every candidate start is tracked alongside its DFA
+// group, and a candidate's match is final once the candidate dies and no earlier candidate is left
+// that could still match and drop it. Candidates that die with a match wait in the pending list until
+// then. Abandoning a candidate at the length limit does not hand the threads it absorbed back to the
+// later starts that shared them, which is the price of never rescanning.
+struct RegexSearcher
+{
+	RegexDfa dfa;
+	size_t maxLength;
+	vector<RegexCandidate> candidates;
+	deque<RegexCandidate> pending;
+
+	RegexSearcher(const BinaryRegexProgram* program, size_t maxMatchLength):
+		dfa(program, &program->forward), maxLength(maxMatchLength)
+	{
+	}
+
+	void AddPending(const RegexCandidate& candidate)
+	{
+		auto i = pending.end();
+		while ((i != pending.begin()) && ((i - 1)->start > candidate.start))
+			--i;
+		pending.insert(i, candidate);
+	}
+
+	void Apply(const RegexStep& step, size_t pos)
+	{
+		size_t count = candidates.size();
+		if (step.accepted != RegexNoGroup)
+		{
+			RegexCandidate& accepted = candidates[step.accepted];
+			accepted.end = pos;
+			while (!pending.empty() && (pending.back().start > accepted.start))
+				pending.pop_back();
+			count = step.accepted + 1;
+		}
+
+		size_t survivor = 0;
+		size_t write = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if ((survivor < step.survivors.size()) && (step.survivors[survivor] == i))
+			{
+				candidates[write++] = candidates[i];
+				survivor++;
+			}
+			else if (candidates[i].end != 0)
+			{
+				AddPending(candidates[i]);
+			}
+		}
+		candidates.resize(write);
+
+		if (step.fresh)
+		{
+			RegexCandidate candidate;
+			candidate.start = pos;
+			candidate.end = 0;
+			candidates.push_back(candidate);
+		}
+	}
+
+	// Reports pending matches that no live candidate starts before. Matches starting at or after
+	// scanLength are left for the next block.
+	bool Report(size_t scanLength, uint64_t address, size_t& resume,
+		const function<bool(const RegexMatch& match)>& callback)
+	{
+		while (!pending.empty() && (candidates.empty() || (pending.front().start < candidates[0].start)))
+		{
+			RegexCandidate candidate = pending.front();
+			pending.pop_front();
+			if (candidate.start >= scanLength)
+			{
+				pending.clear();
+				return true;
+			}
+
+			RegexMatch match;
+			match.address = address + candidate.start;
+			match.length = candidate.end - candidate.start;
+			resume = candidate.end;
+			if (!callback(match))
+				return false;
+		}
+		return true;
+	}
+
+	// Reports the matches in data that start at or after pos and before scanLength. resume receives the
+	// end of the last match reported, or is left alone if there were none.
+	bool Search(const uint8_t* data, size_t len, size_t pos, size_t scanLength, uint64_t address, size_t& resume,
+		const function<bool(const RegexMatch& match)>& callback)
+	{
+		if (pos >= scanLength)
+			return true;
+
+		candidates.clear();
+		pending.clear();
+		RegexCandidate first;
+		first.start = pos;
+		first.end = 0;
+		candidates.push_back(first);
+		uint32_t state = dfa.Start();
+		for (size_t i = pos; i < len; i++)
+		{
+			// The earliest candidate is abandoned once it reaches the length limit, keeping the longest
+			// match it found within it
+			if ((i - candidates[0].start) >= maxLength)
+			{
+				if (candidates[0].end != 0)
+					AddPending(candidates[0]);
+				candidates.erase(candidates.begin());
+				state = dfa.WithoutFirstGroup(state);
+				if (candidates.empty())
+				{
+					first.start = i;
+					candidates.push_back(first);
+				}
+				if (!pending.empty() && !Report(scanLength, address, resume, callback))
+					return false;
+			}
+
+			// Everything before the end of the scan region has been reported
+			if (candidates[0].start >= scanLength)
+				return true;
+
+			uint32_t step;
+			state = dfa.Next(state, data[i], step);
+			const RegexStep& change = dfa.GetStep(step);
+			if (change.unchanged)
+				continue;
+			if (change.restart && (candidates.size() == 1) && (candidates[0].end == 0))
+			{
+				candidates[0].start = i + 1;
+				continue;
+			}
+			Apply(change, i + 1);
+			if (!pending.empty() && !Report(scanLength, address, resume, callback))
+				return false;
+		}
+
+		// Every candidate still running ends with the data
+		for (auto& i : candidates)
+		{
+			if (i.end != 0)
+				AddPending(i);
+		}
+		candidates.clear();
+		return Report(scanLength, address, resume, callback);
+	}
+};
+
+
+static bool StartAccepts(const RegexNfa& nfa)
+{
+	vector<bool> visited(nfa.states.size(), false);
+	vector<uint32_t> stack(1, nfa.start);
+	while (!stack.empty())
+	{
+		uint32_t cur = stack.back();
+		stack.pop_back();
+		if (visited[cur])
+			continue;
+		visited[cur] = true;
+		if (nfa.states[cur].type == NfaAccept)
+			return true;
+		if (nfa.states[cur].type == NfaSplit)
+		{
+			stack.push_back(nfa.states[cur].out);
+			stack.push_back(nfa.states[cur].alt);
+		}
+	}
+	return false;
+}
+
+
+BinaryRegex::BinaryRegex(BinaryRegexProgram* program, size_t maxMatchLength):
+	m_program(program), m_maxMatchLength(maxMatchLength)
+{
+}
+
+
+BinaryRegex::~BinaryRegex()
+{
+	delete m_program;
+}
+
+
+Ref<BinaryRegex> BinaryRegex::Compile(const string& pattern, string& errors, BNFindFlag flags, size_t maxMatchLength)
+{
+	RegexParser parser(pattern, (flags & FindCaseInsensitive) != 0);
+	size_t root;
+	if (!parser.Parse(root))
+	{
+		errors = parser.error;
+		return nullptr;
+	}
+
+	BinaryRegexProgram* program = new BinaryRegexProgram;
+	program->sets = parser.sets;
+	RegexNfaBuilder builder(parser.nodes);
+	RegexNfaState accept;
+	accept.type = NfaAccept;
+	accept.set = accept.out = accept.alt = 0;
+	builder.nfa.states.push_back(accept);
+	builder.nfa.start = builder.Build(root, 0);
+	if (builder.tooLarge)
+	{
+		delete program;
+		errors = "pattern is too large";
+		return nullptr;
+	}
+	program->forward = builder.nfa;
+
+	if (StartAccepts(program->forward))
+	{
+		delete program;
+		errors = "pattern matches empty input";
+		return nullptr;
+	}
+
+	// Bytes that every set treats the same way share a class, which keeps the DFA tables small
+	for (size_t i = 0; i < 256; i++)
+		program->byteClasses[i] = 0;
+	program->classCount = 1;
+	for (auto& set : program->sets)
+	{
+		map<pair<uint8_t, bool>, uint8_t> split;
+		for (size_t i = 0; i < 256; i++)
+		{
+			pair<uint8_t, bool> key(program->byteClasses[i], set.Contains((uint8_t)i));
+			auto existing = split.find(key);
+			if (existing == split.end())
+				existing = split.insert(make_pair(key, (uint8_t)split.size())).first;
+			program->byteClasses[i] = existing->second;
+		}
+		program->classCount = split.size();
+	}
+
+	errors.clear();
+	if (maxMatchLength == 0)
+		maxMatchLength = 1;
+	return new BinaryRegex(program, maxMatchLength);
+}
+
+
+bool BinaryRegex::Search(const uint8_t* data, size_t len, uint64_t address,
+	const function<bool(const RegexMatch& match)>& callback) const
+{
+	RegexSearcher searcher(m_program, m_maxMatchLength);
+	size_t resume = 0;
+	return searcher.Search(data, len, 0, len, address, resume, callback);
+}
+
+
+bool BinaryRegex::Search(BinaryView* view, uint64_t start, uint64_t end,
+	const function<bool(const RegexMatch& match)>& callback) const
+{
+	// Blocks overlap by the match length limit, so every match starting within a block's scan
+	// region is complete within that block. Matches never overlap, so each block resumes after the
+	// last match reported by the previous one.
+	RegexSearcher searcher(m_program, m_maxMatchLength);
+	uint64_t resumeAddress = start;
+	size_t blockSize = max((size_t)0x100000, m_maxMatchLength);
+	return view->ScanData(start, end, m_maxMatchLength, [&](const DataScanBlock& block) {
+		size_t pos = 0;
+		if (resumeAddress > block.address)
+			pos = (size_t)min((uint64_t)block.scanLength, resumeAddress - block.address);
+		size_t resume = 0;
+		bool result = searcher.Search(block.data, block.length, pos, block.scanLength, block.address, resume, callback);
+		if (resume != 0)
+			resumeAddress = block.address + resume;
+		return result;
+	}, blockSize);
+}
@@ -18,7 +18,11 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
+#include <algorithm>
+#include <thread>
 #include "binaryninjaapi.h"
+#include "simd.h"
 
 using namespace BinaryNinja;
 using namespace std;
@@ -585,12 +589,24 @@ size_t BinaryView::WriteBuffer(uint64_t offset, const DataBuffer& data)
 }
 
 
+size_t BinaryView::WriteBuffer(uint64_t offset, const DataBufferView& data)
+{
+	return BNWriteViewData(m_object, offset, data.GetData(), data.GetLength());
+}
+
+
 size_t BinaryView::InsertBuffer(uint64_t offset, const DataBuffer& data)
 {
 	return BNInsertViewBuffer(m_object, offset, data.GetBufferObject());
 }
 
 
+size_t BinaryView::InsertBuffer(uint64_t offset, const DataBufferView& data)
+{
+	return BNInsertViewData(m_object, offset, data.GetData(), data.GetLength());
+}
+
+
 vector<BNModificationStatus> BinaryView::GetModification(uint64_t offset, size_t len)
 {
 	BNModificationStatus* mod = new BNModificationStatus[len];
@@ -635,6 +651,120 @@ size_t BinaryView::Read(void* dest, uint64_t offset, size_t len)
 }
 
 
+bool BinaryView::ReadRanges(const vector<ReadRange>& ranges, void* dest, vector<size_t>& bytesRead, size_t maxGap)
+{
+	// Single reads are capped so that a long run of nearby ranges does not turn into one huge read
+	static const uint64_t maxClusterSize = 0x100000;
+
+	uint8_t* out = (uint8_t*)dest;
+	vector<size_t> destOffsets(ranges.size());
+	size_t totalLength = 0;
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		destOffsets[i] = totalLength;
+		totalLength += ranges[i].length;
+	}
+	bytesRead.assign(ranges.size(), 0);
+
+	vector<size_t> order;
+	order.reserve(ranges.size());
+	for (size_t i = 0; i < ranges.size(); i++)
+	{
+		if (ranges[i].length != 0)
+			order.push_back(i);
+	}
+	sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ranges[a].offset < ranges[b].offset; });
+
+	bool complete = true;
+	vector<uint8_t> cluster;
+	size_t first = 0;
+	while (first < order.size())
+	{
+		// Grow the cluster while the next range starts close enough to the end of the current one
+		uint64_t clusterStart = ranges[order[first]].offset;
+		uint64_t clusterEnd = clusterStart + ranges[order[first]].length;
+		size_t last = first + 1;
+		for (; last < order.size(); last++)
+		{
+			const ReadRange& next = ranges[order[last]];
+			if ((next.offset > clusterEnd) && ((next.offset - clusterEnd) > maxGap))
+				break;
+			uint64_t nextEnd = max(clusterEnd, next.offset + next.length);
+			if ((nextEnd - clusterStart) > maxClusterSize)
+				break;
+			clusterEnd = nextEnd;
+		}
+
+		size_t clusterLength = (size_t)(clusterEnd - clusterStart);
+		size_t done = last;
+		if (last == (first + 1))
+		{
+			// Lone ranges are read straight into place
+			size_t index = order[first];
+			bytesRead[index] = Read(out + destOffsets[index], clusterStart, clusterLength);
+		}
+		else
+		{
+			cluster.resize(clusterLength);
+			size_t clusterRead = Read(&cluster[0], clusterStart, clusterLength);
+			uint64_t readEnd = clusterStart + clusterRead;
+			for (done = first; done < last; done++)
+			{
+				size_t index = order[done];
+				const ReadRange& range = ranges[index];
+				if ((range.offset + range.length) <= readEnd)
+				{
+					memcpy(out + destOffsets[index], &cluster[(size_t)(range.offset - clusterStart)], range.length);
+					bytesRead[index] = range.length;
+				}
+				else if (range.offset < readEnd)
+				{
+					bytesRead[index] = Read(out + destOffsets[index], range.offset, range.length);
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			if (done < last)
+			{
+				// The read stopped at an unreadable offset. Ranges starting before the next valid
+				// offset cannot be read at all; clustering resumes with the ranges after them.
+				uint64_t nextValid = GetNextValidOffset(readEnd);
+				while ((done < last) && (ranges[order[done]].offset < nextValid))
+					done++;
+				if (done == first)
+					done++;
+			}
+		}
+
+		for (size_t i = first; i < done; i++)
+		{
+			size_t index = order[i];
+			if (bytesRead[index] < ranges[index].length)
+			{
+				memset(out + destOffsets[index] + bytesRead[index], 0, ranges[index].length - bytesRead[index]);
+				complete = false;
+			}
+		}
+		first = done;
+	}
+	return complete;
+}
+
+
+bool BinaryView::ReadRanges(const vector<ReadRange>& ranges, DataBuffer& output, vector<size_t>& bytesRead,
+	size_t maxGap)
+{
+	size_t totalLength = 0;
+	for (auto& i : ranges)
+		totalLength += i.length;
+	output.SetSize(totalLength);
+	return ReadRanges(ranges, output.GetData(), bytesRead, maxGap);
+}
+
+
 size_t BinaryView::Write(uint64_t offset, const void* data, size_t len)
 {
 	return BNWriteViewData(m_object, offset, data, len);
@@ -994,8 +1124,91 @@ vector<ReferenceSource> BinaryView::GetCodeReferences(uint64_t addr, uint64_t le
 }
 
 
+void BinaryView::GetCodeReferences(const vector<uint64_t>& targets, CodeReferenceTable& result)
+{
+	result.Clear();
+	result.targets = targets;
+	sort(result.targets.begin(), result.targets.end());
+	result.targets.erase(unique(result.targets.begin(), result.targets.end()), result.targets.end());
+
+	// Runs of targets checked with one range query are limited in count and spacing, so that the range
+	// does not take in many references to addresses that were not asked for
+	static const size_t maxRunTargets = 64;
+	static const uint64_t maxRunGap = 0x100;
+
+	result.offsets.reserve(result.targets.size() + 1);
+	result.offsets.push_back(0);
+	vector<pair<uint64_t, uint64_t>> refList;
+	for (size_t first = 0; first < result.targets.size(); )
+	{
+		// The core only reports references by target address or by address range, and range results do
+		// not say which address they refer to. Runs of nearby targets are checked with a single range
+		// query first, so targets without references, which are most of them in a dense batch, cost no
+		// call of their own.
+		size_t last = first + 1;
+		while ((last < result.targets.size()) && ((last - first) < maxRunTargets) &&
+			((result.targets[last] - result.targets[last - 1]) <= maxRunGap))
+			last++;
+
+		bool empty = false;
+		if ((last - first) > 1)
+		{
+			size_t count;
+			BNReferenceSource* refs = BNGetCodeReferencesInRange(m_object, result.targets[first],
+				result.targets[last - 1] - result.targets[first] + 1, &count);
+			BNFreeCodeReferences(refs, count);
+			empty = (count == 0);
+		}
+
+		for (size_t i = first; i < last; i++)
+		{
+			if (!empty)
+			{
+				size_t count;
+				BNReferenceSource* refs = BNGetCodeReferences(m_object, result.targets[i], &count);
+				refList.clear();
+				for (size_t j = 0; j < count; j++)
+					refList.push_back(pair<uint64_t, uint64_t>(refs[j].addr, BNGetFunctionStart(refs[j].func)));
+				BNFreeCodeReferences(refs, count);
+
+				sort(refList.begin(), refList.end());
+				for (auto& j : refList)
+				{
+					result.sources.push_back(j.first);
+					result.functions.push_back(j.second);
+				}
+			}
+			result.offsets.push_back(result.sources.size());
+		}
+		first = last;
+	}
+}
+
+
+void CodeReferenceTable::Clear()
+{
+	targets.clear();
+	offsets.clear();
+	sources.clear();
+	functions.clear();
+}
+
+
+size_t CodeReferenceTable::GetTargetIndex(uint64_t target) const
+{
+	auto i = lower_bound(targets.begin(), targets.end(), target);
+	if ((i == targets.end()) || (*i != target))
+		return targets.size();
+	return (size_t)(i - targets.begin());
+}
+
+
 Ref<Symbol> BinaryView::GetSymbolByAddress(uint64_t addr)
 {
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+		return cache->GetSymbolByAddress(addr);
+
 	BNSymbol* sym = BNGetSymbolByAddress(m_object, addr);
 	if (!sym)
 		return nullptr;
@@ -1005,6 +1218,10 @@ Ref<Symbol> BinaryView::GetSymbolByAddress(uint64_t addr)
 
 Ref<Symbol> BinaryView::GetSymbolByRawName(const string& name)
 {
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+		return cache->GetSymbolByRawName(name);
+
 	BNSymbol* sym = BNGetSymbolByRawName(m_object, name.c_str());
 	if (!sym)
 		return nullptr;
@@ -1014,6 +1231,10 @@ Ref<Symbol> BinaryView::GetSymbolByRawName(const string& name)
 
 vector<Ref<Symbol>> BinaryView::GetSymbolsByName(const string& name)
 {
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+		return cache->GetSymbolsByName(name);
+
 	size_t count;
 	BNSymbol** syms = BNGetSymbolsByName(m_object, name.c_str(), &count);
 
@@ -1085,30 +1306,82 @@ vector<Ref<Symbol>> BinaryView::GetSymbolsOfType(BNSymbolType type, uint64_t sta
 void BinaryView::DefineAutoSymbol(Symbol* sym)
 {
 	BNDefineAutoSymbol(m_object, sym->GetObject());
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+		cache->Update(sym);
 }
 
 
 void BinaryView::UndefineAutoSymbol(Symbol* sym)
 {
 	BNUndefineAutoSymbol(m_object, sym->GetObject());
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+		cache->Update(sym);
 }
 
 
 void BinaryView::DefineUserSymbol(Symbol* sym)
 {
 	BNDefineUserSymbol(m_object, sym->GetObject());
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+		cache->Update(sym);
 }
 
 
 void BinaryView::UndefineUserSymbol(Symbol* sym)
 {
 	BNUndefineUserSymbol(m_object, sym->GetObject());
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+		cache->Update(sym);
 }
 
 
 void BinaryView::DefineImportedFunction(Symbol* importAddressSym, Function* func)
 {
 	BNDefineImportedFunction(m_object, importAddressSym->GetObject(), func->GetObject());
+	Ref<SymbolCache> cache = GetSymbolCache();
+	if (cache)
+	{
+		BNSymbol* sym = BNGetSymbolByAddress(m_object, func->GetStart());
+		if (sym)
+		{
+			Ref<Symbol> importSym = new Symbol(sym);
+			cache->Update(importSym);
+		}
+	}
+}
+
+
+void BinaryView::EnableSymbolCache()
+{
+	// The symbols are loaded without holding the lock, so lookups keep going to the core meanwhile
+	if (GetSymbolCache())
+		return;
+	Ref<SymbolCache> cache = new SymbolCache(this);
+	lock_guard<mutex> lock(m_symbolCacheMutex);
+	if (!m_symbolCache)
+		m_symbolCache = cache;
+}
+
+
+void BinaryView::DisableSymbolCache()
+{
+	// The cache is released after the lock is dropped. Lookups already in progress hold their own
+	// reference to it.
+	Ref<SymbolCache> cache;
+	lock_guard<mutex> lock(m_symbolCacheMutex);
+	cache = m_symbolCache;
+	m_symbolCache = nullptr;
+}
+
+
+Ref<SymbolCache> BinaryView::GetSymbolCache() const
+{
+	lock_guard<mutex> lock(m_symbolCacheMutex);
+	return m_symbolCache;
 }
 
 
@@ -1427,6 +1700,699 @@ bool BinaryView::FindNextData(uint64_t start, const DataBuffer& data, uint64_t&
 }
 
 
+bool BinaryView::FindNextData(uint64_t start, const DataBufferView& data, uint64_t& result, BNFindFlag flags)
+{
+	// The core search takes a core buffer, so only the (typically short) pattern is copied here
+	BNDataBuffer* buf = BNCreateDataBuffer(data.GetData(), data.GetLength());
+	bool found = BNFindNextData(m_object, start, buf, &result, flags);
+	BNFreeDataBuffer(buf);
+	return found;
+}
+
+
+// Reads [start, end) in blocks for ScanData. If stop is given, it is polled before every read so
+// that a cancelled scan does not read another block.
+static bool ScanViewData(BinaryView* view, uint64_t start, uint64_t end, size_t overlap,
+	const function<bool(const DataScanBlock& block)>& callback, size_t blockSize, const function<bool()>& stop)
+{
+	if (blockSize == 0)
+		blockSize = 0x100000;
+	vector<uint8_t> buffer(blockSize + overlap);
+
+	uint64_t pos = start;
+	size_t carried = 0;
+	while (pos < end)
+	{
+		if (stop && stop())
+			return false;
+		size_t wanted = (size_t)min((uint64_t)buffer.size(), end - pos);
+		size_t valid = carried + view->Read(&buffer[carried], pos + carried, wanted - carried);
+
+		// A short read means the readable region ends here, so nothing after it can extend a match
+		bool regionEnds = (valid < wanted) || ((pos + valid) == end);
+		DataScanBlock block;
+		block.address = pos;
+		block.data = &buffer[0];
+		block.length = valid;
+		block.scanLength = regionEnds ? valid : (valid - overlap);
+		if ((valid != 0) && !callback(block))
+			return false;
+
+		if (regionEnds)
+		{
+			uint64_t next = pos + valid;
+			if (next >= end)
+				break;
+			// A read can also stop short at a valid offset, such as at a segment boundary, so the
+			// next read starts there. A byte is only skipped when a read starting at it returns nothing.
+			uint64_t nextValid = view->GetNextValidOffset(next);
+			if (nextValid > next)
+				pos = nextValid;
+			else
+				pos = (valid != 0) ? next : (next + 1);
+			carried = 0;
+		}
+		else
+		{
+			// Keep the overlapping tail instead of reading it again
+			memmove(&buffer[0], &buffer[block.scanLength], overlap);
+			pos += block.scanLength;
+			carried = overlap;
+		}
+	}
+	return true;
+}
+
+
+bool BinaryView::ScanData(uint64_t start, uint64_t end, size_t overlap,
+	const function<bool(const DataScanBlock& block)>& callback, size_t blockSize)
+{
+	return ScanViewData(this, start, end, overlap, callback, blockSize, function<bool()>());
+}
+
+
+bool BinaryView::FindNextPattern(uint64_t start, const BytePattern& pattern, uint64_t& result)
+{
+	return FindNextPattern(start, GetEnd(), pattern, result);
+}
+
+
+bool BinaryView::FindNextPattern(uint64_t start, uint64_t end, const BytePattern& pattern, uint64_t& result)
+{
+	bool found = false;
+	FindAllPattern(start, end, pattern, [&](uint64_t address) {
+		result = address;
+		found = true;
+		return false;
+	});
+	return found;
+}
+
+
+bool BinaryView::FindAllPattern(uint64_t start, uint64_t end, const BytePattern& pattern,
+	const function<bool(uint64_t address)>& callback)
+{
+	if (pattern.IsEmpty())
+		return true;
+
+	return ScanData(start, end, pattern.GetLength() - 1, [&](const DataScanBlock& block) {
+		size_t offset = 0;
+		while (pattern.Find(block.data, block.length, offset, offset) && (offset < block.scanLength))
+		{
+			if (!callback(block.address + offset))
+				return false;
+			offset++;
+		}
+		return true;
+	});
+}
+
+
+static bool IsSearchCancelled(const ParallelSearchSettings& settings)
+{
+	return settings.cancel && settings.cancel->load(memory_order_relaxed);
+}
+
+
+// Scans [start, end) in fixed size chunks on a pool of threads. Each chunk is read in ScanData blocks
+// with overlap bytes of lookahead past its end, and blocks are clipped so matches are only reported
+// within their own chunk. Chunks with an index above chunkLimit are skipped, which lets a search for
+// the first match abandon work that can no longer produce it.
+static bool ScanChunksParallel(BinaryView* view, uint64_t start, uint64_t end, size_t overlap,
+	const ParallelSearchSettings& settings, const atomic<size_t>& chunkLimit,
+	const function<bool(size_t chunk, const DataScanBlock& block)>& scan)
+{
+	if (start >= end)
+		return true;
+	uint64_t chunkSize = max(settings.chunkSize, (uint64_t)overlap + 1);
+	size_t chunkCount = (size_t)(((end - start) + chunkSize - 1) / chunkSize);
+
+	atomic<size_t> nextChunk(0);
+	atomic<bool> cancelled(false);
+	auto worker = [&]() {
+		while (true)
+		{
+			if (IsSearchCancelled(settings))
+			{
+				cancelled = true;
+				return;
+			}
+			size_t chunk = nextChunk.fetch_add(1);
+			if ((chunk >= chunkCount) || (chunk > chunkLimit.load()))
+				return;
+
+			uint64_t chunkStart = start + (chunk * chunkSize);
+			uint64_t chunkEnd = min(chunkStart + chunkSize, end);
+			uint64_t scanEnd = ((end - chunkEnd) > overlap) ? (chunkEnd + overlap) : end;
+			ScanViewData(view, chunkStart, scanEnd, overlap, [&](const DataScanBlock& block) {
+				if (block.address >= chunkEnd)
+					return false;
+				DataScanBlock clipped = block;
+				clipped.scanLength = (size_t)min((uint64_t)block.scanLength, chunkEnd - block.address);
+				return scan(chunk, clipped);
+			}, 0, [&]() {
+				if (IsSearchCancelled(settings))
+				{
+					cancelled = true;
+					return true;
+				}
+				return chunk > chunkLimit.load();
+			});
+		}
+	};
+
+	size_t threadCount = settings.threadCount;
+	if (threadCount == 0)
+		threadCount = max(thread::hardware_concurrency(), 1u);
+	threadCount = min(threadCount, chunkCount);
+
+	vector<thread> threads;
+	for (size_t i = 1; i < threadCount; i++)
+		threads.push_back(thread(worker));
+	worker();
+	for (auto& i : threads)
+		i.join();
+	return !cancelled;
+}
+
+
+bool BinaryView::FindNextPatternParallel(uint64_t start, uint64_t end, const BytePattern& pattern, uint64_t& result,
+	const ParallelSearchSettings& settings)
+{
+	if (pattern.IsEmpty())
+		return false;
+
+	// Once a chunk finds a match, later chunks cannot hold the first one and are skipped
+	atomic<size_t> chunkLimit((size_t)-1);
+	mutex resultMutex;
+	bool found = false;
+	bool completed = ScanChunksParallel(this, start, end, pattern.GetLength() - 1, settings, chunkLimit,
+		[&](size_t chunk, const DataScanBlock& block) {
+			size_t offset;
+			if (!pattern.Find(block.data, block.length, 0, offset) || (offset >= block.scanLength))
+				return true;
+
+			lock_guard<mutex> lock(resultMutex);
+			uint64_t address = block.address + offset;
+			if (!found || (address < result))
+			{
+				result = address;
+				found = true;
+			}
+			if (chunk < chunkLimit)
+				chunkLimit = chunk;
+			return false;
+		});
+
+	// A cancelled search may have skipped an earlier match, so its result is not reported
+	return completed && found;
+}
+
+
+bool BinaryView::FindAllPatternParallel(uint64_t start, uint64_t end, const BytePattern& pattern,
+	vector<uint64_t>& results, const ParallelSearchSettings& settings)
+{
+	results.clear();
+	if (pattern.IsEmpty() || (start >= end))
+		return true;
+
+	// Each chunk collects its own matches; concatenating them in chunk order gives address order
+	uint64_t chunkSize = max(settings.chunkSize, (uint64_t)pattern.GetLength());
+	vector<vector<uint64_t>> chunkResults((size_t)(((end - start) + chunkSize - 1) / chunkSize));
+	ParallelSearchSettings chunkSettings = settings;
+	chunkSettings.chunkSize = chunkSize;
+
+	atomic<size_t> chunkLimit((size_t)-1);
+	bool completed = ScanChunksParallel(this, start, end, pattern.GetLength() - 1, chunkSettings, chunkLimit,
+		[&](size_t chunk, const DataScanBlock& block) {
+			size_t offset = 0;
+			while (pattern.Find(block.data, block.length, offset, offset) && (offset < block.scanLength))
+			{
+				chunkResults[chunk].push_back(block.address + offset);
+				offset++;
+			}
+			return true;
+		});
+
+	size_t total = 0;
+	for (auto& i : chunkResults)
+		total += i.size();
+	results.reserve(total);
+	for (auto& i : chunkResults)
+		results.insert(results.end(), i.begin(), i.end());
+	return completed;
+}
+
+
+bool BinaryView::FindAllDataParallel(uint64_t start, uint64_t end, const DataBufferView& data,
+	vector<uint64_t>& results, BNFindFlag flags, const ParallelSearchSettings& settings)
+{
+	vector<uint8_t> bytes(data.begin(), data.end());
+	vector<uint8_t> mask(bytes.size(), 0xff);
+	if (flags & FindCaseInsensitive)
+	{
+		// Clearing bit 5 of the mask for ASCII letters matches both cases and nothing else
+		for (size_t i = 0; i < bytes.size(); i++)
+		{
+			uint8_t folded = bytes[i] & 0xdf;
+			if ((folded >= 'A') && (folded <= 'Z'))
+				mask[i] = 0xdf;
+		}
+	}
+	return FindAllPatternParallel(start, end, BytePattern(bytes, mask), results, settings);
+}
+
+
+struct StringEncoding
+{
+	BNStringType type;
+	size_t unitSize;
+	bool bigEndian;
+};
+
+
+struct StringRun
+{
+	uint64_t start;
+	uint64_t end;
+};
+
+
+static inline bool IsPrintableStringChar(uint32_t ch)
+{
+	return ((ch >= 0x20) && (ch < 0x7f)) || (ch == '\t') || (ch == '\n') || (ch == '\r');
+}
+
+
+static bool IsPrintableStringUnit(const uint8_t* unit, const StringEncoding& encoding)
+{
+	uint32_t value = 0;
+	if (encoding.bigEndian)
+	{
+		for (size_t i = 0; i < encoding.unitSize; i++)
+			value = (value << 8) | unit[i];
+	}
+	else
+	{
+		for (size_t i = encoding.unitSize; i > 0; i--)
+			value = (value << 8) | unit[i - 1];
+	}
+	return IsPrintableStringChar(value);
+}
+
+
+#ifdef BN_SIMD_SSE2
+static inline __m128i ClassifyPrintable16(__m128i value)
+{
+	__m128i printable = _mm_and_si128(_mm_cmpgt_epi16(value, _mm_set1_epi16(0x1f)),
+		_mm_cmplt_epi16(value, _mm_set1_epi16(0x7f)));
+	__m128i whitespace = _mm_or_si128(_mm_cmpeq_epi16(value, _mm_set1_epi16('\t')),
+		_mm_or_si128(_mm_cmpeq_epi16(value, _mm_set1_epi16('\n')), _mm_cmpeq_epi16(value, _mm_set1_epi16('\r'))));
+	return _mm_or_si128(printable, whitespace);
+}
+
+
+static inline __m128i ClassifyPrintable32(__m128i value)
+{
+	__m128i printable = _mm_and_si128(_mm_cmpgt_epi32(value, _mm_set1_epi32(0x1f)),
+		_mm_cmplt_epi32(value, _mm_set1_epi32(0x7f)));
+	__m128i whitespace = _mm_or_si128(_mm_cmpeq_epi32(value, _mm_set1_epi32('\t')),
+		_mm_or_si128(_mm_cmpeq_epi32(value, _mm_set1_epi32('\n')), _mm_cmpeq_epi32(value, _mm_set1_epi32('\r'))));
+	return _mm_or_si128(printable, whitespace);
+}
+
+
+// Each classifier returns a mask with one bit per character for the 64 characters at data
+static uint64_t ClassifyAsciiSSE2(const uint8_t* data)
+{
+	const __m128i low = _mm_set1_epi8(0x1f);
+	const __m128i high = _mm_set1_epi8(0x7f);
+	uint64_t result = 0;
+	for (size_t i = 0; i < 4; i++)
+	{
+		// Signed compares also reject bytes 0x80 and above, which are negative
+		__m128i block = _mm_loadu_si128((const __m128i*)(data + (i * 16)));
+		__m128i printable = _mm_and_si128(_mm_cmpgt_epi8(block, low), _mm_cmplt_epi8(block, high));
+		__m128i whitespace = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')),
+			_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+		result |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_or_si128(printable, whitespace)) << (i * 16);
+	}
+	return result;
+}
+
+
+static uint64_t ClassifyUtf16SSE2(const uint8_t* data, bool bigEndian)
+{
+	uint64_t result = 0;
+	for (size_t i = 0; i < 8; i++)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*)(data + (i * 16)));
+		__m128i value = bigEndian ? _mm_srli_epi16(block, 8) : _mm_and_si128(block, _mm_set1_epi16(0xff));
+		__m128i upper = _mm_and_si128(block, _mm_set1_epi16(bigEndian ? 0x00ff : (short)0xff00));
+		__m128i valid = _mm_and_si128(ClassifyPrintable16(value), _mm_cmpeq_epi16(upper, _mm_setzero_si128()));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(valid, _mm_setzero_si128())) & 0xff;
+		result |= (uint64_t)mask << (i * 8);
+	}
+	return result;
+}
+
+
+static uint64_t ClassifyUtf32SSE2(const uint8_t* data, bool bigEndian)
+{
+	uint64_t result = 0;
+	for (size_t i = 0; i < 16; i++)
+	{
+		__m128i block = _mm_loadu_si128((const __m128i*)(data + (i * 16)));
+		__m128i value = bigEndian ? _mm_srli_epi32(block, 24) : _mm_and_si128(block, _mm_set1_epi32(0xff));
+		__m128i upper = _mm_and_si128(block, _mm_set1_epi32(bigEndian ? 0x00ffffff : (int)0xffffff00));
+		__m128i valid = _mm_and_si128(ClassifyPrintable32(value), _mm_cmpeq_epi32(upper, _mm_setzero_si128()));
+		uint32_t mask = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(valid));
+		result |= (uint64_t)mask << (i * 4);
+	}
+	return result;
+}
+#endif
+
+
+#ifdef BN_SIMD_X86
+BN_SIMD_TARGET("avx2")
+static uint64_t ClassifyAsciiAVX2(const uint8_t* data)
+{
+	const __m256i low = _mm256_set1_epi8(0x1f);
+	const __m256i high = _mm256_set1_epi8(0x7f);
+	uint64_t result = 0;
+	for (size_t i = 0; i < 2; i++)
+	{
+		__m256i block = _mm256_loadu_si256((const __m256i*)(data + (i * 32)));
+		__m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(block, low), _mm256_cmpgt_epi8(high, block));
+		__m256i whitespace = _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t')),
+			_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')),
+			_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r'))));
+		result |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_or_si256(printable, whitespace)) << (i * 32);
+	}
+	return result;
+}
+#endif
+
+
+// Tracks runs of printable characters in one encoding across the blocks of a single chunk. Runs
+// shorter than the minimum are kept if they touch either end of the chunk, since they may continue
+// into a neighbouring chunk and are only filtered after runs are joined across chunks.
+class StringRunScanner
+{
+	StringEncoding m_encoding;
+	uint64_t m_origin;
+	uint64_t m_chunkStart;
+	uint64_t m_chunkEnd;
+	size_t m_minLength;
+	bool m_inRun;
+	uint64_t m_runStart;
+	uint64_t m_expected;
+
+	void CloseRun(uint64_t end)
+	{
+		m_inRun = false;
+		uint64_t length = (end - m_runStart) / m_encoding.unitSize;
+		if ((length >= m_minLength) || (m_runStart == m_chunkStart) || (end == m_chunkEnd))
+		{
+			StringRun run;
+			run.start = m_runStart;
+			run.end = end;
+			runs.push_back(run);
+		}
+	}
+
+	void ProcessMask(uint64_t mask, size_t count, uint64_t base)
+	{
+		if (count < 64)
+			mask &= ((uint64_t)1 << count) - 1;
+		size_t pos = 0;
+		while (pos < count)
+		{
+			if (m_inRun)
+			{
+				uint64_t breaks = ~mask >> pos;
+				if (breaks == 0)
+					return;
+				pos += Simd::CountTrailingZeros64(breaks);
+				if (pos >= count)
+					return;
+				CloseRun(base + (pos * m_encoding.unitSize));
+			}
+			else
+			{
+				uint64_t starts = mask >> pos;
+				if (starts == 0)
+					return;
+				pos += Simd::CountTrailingZeros64(starts);
+				m_inRun = true;
+				m_runStart = base + (pos * m_encoding.unitSize);
+			}
+		}
+	}
+
+	uint64_t Classify(const uint8_t* data) const
+	{
+#ifdef BN_SIMD_SSE2
+		if (m_encoding.unitSize == 1)
+		{
+#ifdef BN_SIMD_X86
+			if (Simd::HasAVX2())
+				return ClassifyAsciiAVX2(data);
+#endif
+			return ClassifyAsciiSSE2(data);
+		}
+		if (m_encoding.unitSize == 2)
+			return ClassifyUtf16SSE2(data, m_encoding.bigEndian);
+		return ClassifyUtf32SSE2(data, m_encoding.bigEndian);
+#else
+		return ClassifyScalar(data, 64);
+#endif
+	}
+
+	uint64_t ClassifyScalar(const uint8_t* data, size_t count) const
+	{
+		uint64_t mask = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (IsPrintableStringUnit(data + (i * m_encoding.unitSize), m_encoding))
+				mask |= (uint64_t)1 << i;
+		}
+		return mask;
+	}
+
+public:
+	vector<StringRun> runs;
+
+	StringRunScanner(const StringEncoding& encoding, uint64_t origin, uint64_t chunkStart, uint64_t chunkEnd,
+		size_t minLength): m_encoding(encoding), m_origin(origin), m_chunkStart(chunkStart), m_chunkEnd(chunkEnd),
+		m_minLength(minLength), m_inRun(false), m_runStart(0), m_expected(chunkStart)
+	{
+	}
+
+	void Scan(uint64_t address, const uint8_t* data, size_t len)
+	{
+		if (m_inRun && (address != m_expected))
+			CloseRun(m_expected);
+
+		// Characters are aligned relative to the start of the scan, which may not hold after a gap
+		size_t unitSize = m_encoding.unitSize;
+		size_t skip = (size_t)((unitSize - ((address - m_origin) % unitSize)) % unitSize);
+		if (skip >= len)
+			return;
+		const uint8_t* units = data + skip;
+		uint64_t base = address + skip;
+		size_t count = (len - skip) / unitSize;
+
+		size_t i = 0;
+		for (; (i + 64) <= count; i += 64)
+			ProcessMask(Classify(units + (i * unitSize)), 64, base + (i * unitSize));
+		if (i < count)
+			ProcessMask(ClassifyScalar(units + (i * unitSize), count - i), count - i, base + (i * unitSize));
+
+		m_expected = base + (count * unitSize);
+		if (m_inRun && (m_expected != (address + len)))
+			CloseRun(m_expected);
+	}
+
+	void Finish()
+	{
+		if (m_inRun)
+			CloseRun(m_expected);
+	}
+};
+
+
+bool BinaryView::FindStrings(uint64_t start, uint64_t end, vector<BNStringReference>& results,
+	const StringScanSettings& settings, const ParallelSearchSettings& parallel)
+{
+	results.clear();
+	if (start >= end)
+		return true;
+
+	vector<StringEncoding> encodings;
+	StringEncoding encoding;
+	if (settings.ascii)
+	{
+		encoding.type = AsciiString;
+		encoding.unitSize = 1;
+		encoding.bigEndian = false;
+		encodings.push_back(encoding);
+	}
+	encoding.type = Utf16String;
+	encoding.unitSize = 2;
+	for (size_t i = 0; i < 2; i++)
+	{
+		encoding.bigEndian = (i == 1);
+		if (encoding.bigEndian ? settings.utf16BigEndian : settings.utf16LittleEndian)
+			encodings.push_back(encoding);
+	}
+	encoding.type = Utf32String;
+	encoding.unitSize = 4;
+	for (size_t i = 0; i < 2; i++)
+	{
+		encoding.bigEndian = (i == 1);
+		if (encoding.bigEndian ? settings.utf32BigEndian : settings.utf32LittleEndian)
+			encodings.push_back(encoding);
+	}
+	if (encodings.empty())
+		return true;
+
+	// Chunk boundaries stay aligned to every character size so runs can be joined across them
+	ParallelSearchSettings chunkSettings = parallel;
+	chunkSettings.chunkSize = max((uint64_t)4, parallel.chunkSize & ~(uint64_t)3);
+	uint64_t chunkSize = chunkSettings.chunkSize;
+	size_t chunkCount = (size_t)(((end - start) + chunkSize - 1) / chunkSize);
+	size_t minLength = max(settings.minLength, (size_t)1);
+
+	vector<vector<StringRunScanner>> scanners(chunkCount);
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		uint64_t chunkStart = start + (chunk * chunkSize);
+		uint64_t chunkEnd = min(chunkStart + chunkSize, end);
+		for (auto& i : encodings)
+			scanners[chunk].push_back(StringRunScanner(i, start, chunkStart, chunkEnd, minLength));
+	}
+
+	atomic<size_t> chunkLimit((size_t)-1);
+	bool completed = ScanChunksParallel(this, start, end, 0, chunkSettings, chunkLimit,
+		[&](size_t chunk, const DataScanBlock& block) {
+			for (auto& i : scanners[chunk])
+				i.Scan(block.address, block.data, block.scanLength);
+			return true;
+		});
+
+	// Join runs that continue across chunk boundaries, then apply the minimum length
+	for (size_t i = 0; i < encodings.size(); i++)
+	{
+		vector<StringRun> joined;
+		for (size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			StringRunScanner& scanner = scanners[chunk][i];
+			scanner.Finish();
+			for (auto& run : scanner.runs)
+			{
+				if (!joined.empty() && (joined.back().end == run.start))
+					joined.back().end = run.end;
+				else
+					joined.push_back(run);
+			}
+			scanner.runs.clear();
+		}
+
+		for (auto& run : joined)
+		{
+			if (((run.end - run.start) / encodings[i].unitSize) < minLength)
+				continue;
+			BNStringReference str;
+			str.type = encodings[i].type;
+			str.start = run.start;
+			str.length = (size_t)(run.end - run.start);
+			results.push_back(str);
+		}
+	}
+
+	sort(results.begin(), results.end(), [](const BNStringReference& a, const BNStringReference& b) {
+		if (a.start != b.start)
+			return a.start < b.start;
+		return a.type < b.type;
+	});
+	return completed;
+}
+
+
+bool BinaryView::FindDataPointers(uint64_t start, uint64_t end, vector<DataReference>& results, size_t alignment,
+	const ParallelSearchSettings& settings)
+{
+	results.clear();
+	size_t pointerSize = GetAddressSize();
+	if ((pointerSize == 0) || (pointerSize > 8) || (start >= end))
+		return true;
+	if (alignment == 0)
+		alignment = pointerSize;
+	bool bigEndian = GetDefaultEndianness() == BigEndian;
+	uint64_t viewStart = GetStart();
+	uint64_t viewEnd = GetEnd();
+
+	uint64_t chunkSize = max(settings.chunkSize, (uint64_t)pointerSize);
+	size_t chunkCount = (size_t)(((end - start) + chunkSize - 1) / chunkSize);
+	vector<vector<DataReference>> chunkResults(chunkCount);
+
+	atomic<size_t> chunkLimit((size_t)-1);
+	bool completed = ScanChunksParallel(this, start, end, pointerSize - 1, settings, chunkLimit,
+		[&](size_t chunk, const DataScanBlock& block) {
+			size_t offset = (size_t)((alignment - (block.address % alignment)) % alignment);
+			for (; (offset < block.scanLength) && ((offset + pointerSize) <= block.length); offset += alignment)
+			{
+				const uint8_t* data = block.data + offset;
+				uint64_t value = 0;
+				if (bigEndian)
+				{
+					for (size_t i = 0; i < pointerSize; i++)
+						value = (value << 8) | data[i];
+				}
+				else
+				{
+					for (size_t i = pointerSize; i > 0; i--)
+						value = (value << 8) | data[i - 1];
+				}
+
+				// The bounds check rejects most non-pointer values before asking the view
+				if ((value < viewStart) || (value >= viewEnd) || !IsValidOffset(value))
+					continue;
+				DataReference ref;
+				ref.source = block.address + offset;
+				ref.target = value;
+				chunkResults[chunk].push_back(ref);
+			}
+			return true;
+		});
+
+	for (auto& i : chunkResults)
+		results.insert(results.end(), i.begin(), i.end());
+	return completed;
+}
+
+
+bool BinaryView::FindNextRegex(uint64_t start, uint64_t end, BinaryRegex* regex, RegexMatch& result)
+{
+	bool found = false;
+	regex->Search(this, start, end, [&](const RegexMatch& match) {
+		result = match;
+		found = true;
+		return false;
+	});
+	return found;
+}
+
+
+bool BinaryView::FindAllRegex(uint64_t start, uint64_t end, BinaryRegex* regex,
+	const function<bool(const RegexMatch& match)>& callback)
+{
+	return regex->Search(this, start, end, callback);
+}
+
+
 BinaryData::BinaryData(FileMetadata* file): BinaryView(BNCreateBinaryDataView(file->GetObject()))
 {
 }
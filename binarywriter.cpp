@@ -18,13 +18,57 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
-BinaryWriter::BinaryWriter(BinaryView* data, BNEndianness endian): m_view(data)
+static inline void EncodeLE16(uint8_t* data, uint16_t value)
+{
+	data[0] = (uint8_t)value;
+	data[1] = (uint8_t)(value >> 8);
+}
+
+
+static inline void EncodeLE32(uint8_t* data, uint32_t value)
+{
+	EncodeLE16(data, (uint16_t)value);
+	EncodeLE16(data + 2, (uint16_t)(value >> 16));
+}
+
+
+static inline void EncodeLE64(uint8_t* data, uint64_t value)
+{
+	EncodeLE32(data, (uint32_t)value);
+	EncodeLE32(data + 4, (uint32_t)(value >> 32));
+}
+
+
+static inline void EncodeBE16(uint8_t* data, uint16_t value)
+{
+	data[0] = (uint8_t)(value >> 8);
+	data[1] = (uint8_t)value;
+}
+
+
+static inline void EncodeBE32(uint8_t* data, uint32_t value)
+{
+	EncodeBE16(data, (uint16_t)(value >> 16));
+	EncodeBE16(data + 2, (uint16_t)value);
+}
+
+
+static inline void EncodeBE64(uint8_t* data, uint64_t value)
+{
+	EncodeBE32(data, (uint32_t)(value >> 32));
+	EncodeBE32(data + 4, (uint32_t)value);
+}
+
+
+BinaryWriter::BinaryWriter(BinaryView* data, BNEndianness endian): m_view(data), m_endian(endian),
+	m_stickyErrors(false), m_error(false), m_skipWrites(false), m_combining(false), m_offset(0)
 {
 	m_stream = BNCreateBinaryWriter(data->GetObject());
 	BNSetBinaryWriterEndianness(m_stream, endian);
@@ -33,29 +77,165 @@ BinaryWriter::BinaryWriter(BinaryView* data, BNEndianness endian): m_view(data)
 
 BinaryWriter::~BinaryWriter()
 {
+	// A destructor cannot report the failure to the caller, so it is logged instead
+	size_t pending = m_pending.size();
+	if (!TryFlush())
+		LogError("BinaryWriter: failed to flush %d combined write ranges on destruction", (int)pending);
 	BNFreeBinaryWriter(m_stream);
 }
 
 
 BNEndianness BinaryWriter::GetEndianness() const
 {
-	return BNGetBinaryWriterEndianness(m_stream);
+	return m_endian;
 }
 
 
 void BinaryWriter::SetEndianness(BNEndianness endian)
 {
+	m_endian = endian;
 	BNSetBinaryWriterEndianness(m_stream, endian);
 }
 
 
-void BinaryWriter::Write(const void* src, size_t len)
+void BinaryWriter::SetStickyErrorMode(bool sticky)
 {
-	if (!BNWriteData(m_stream, src, len))
+	m_stickyErrors = sticky;
+	m_skipWrites = sticky && m_error;
+}
+
+
+void BinaryWriter::ClearError()
+{
+	m_error = false;
+	m_skipWrites = false;
+}
+
+
+void BinaryWriter::SetWriteCombining(bool enabled)
+{
+	if (enabled == m_combining)
+		return;
+
+	// The core writer's position is only kept up to date while not combining
+	if (enabled)
+	{
+		m_offset = BNGetWriterPosition(m_stream);
+		m_combining = true;
+	}
+	else
+	{
+		bool ok = TryFlush();
+		m_combining = false;
+		BNSeekBinaryWriter(m_stream, m_offset);
+		if (!ok)
+			WriteFailed();
+	}
+}
+
+
+void BinaryWriter::AddPendingWrite(uint64_t offset, const uint8_t* data, size_t len)
+{
+	uint64_t end = offset + len;
+
+	// Find the first pending range that overlaps or touches the new one
+	auto first = m_pending.upper_bound(offset);
+	if (first != m_pending.begin())
+	{
+		auto prev = first;
+		--prev;
+		if ((prev->first + prev->second.size()) >= offset)
+			first = prev;
+	}
+
+	// Sequential writes extend the range that ends exactly where they start
+	if ((first != m_pending.end()) && (first->first <= offset))
+	{
+		auto next = first;
+		++next;
+		if ((next == m_pending.end()) || (next->first > end))
+		{
+			vector<uint8_t>& range = first->second;
+			size_t pos = (size_t)(offset - first->first);
+			if ((pos + len) > range.size())
+				range.resize(pos + len);
+			memcpy(&range[pos], data, len);
+			return;
+		}
+	}
+
+	// Merge every range overlapping or touching [offset, end) into a single new range
+	uint64_t start = offset;
+	auto last = first;
+	while ((last != m_pending.end()) && (last->first <= end))
+	{
+		if (last->first < start)
+			start = last->first;
+		if ((last->first + last->second.size()) > end)
+			end = last->first + last->second.size();
+		++last;
+	}
+
+	vector<uint8_t> merged((size_t)(end - start));
+	for (auto i = first; i != last; ++i)
+		memcpy(&merged[(size_t)(i->first - start)], i->second.data(), i->second.size());
+	memcpy(&merged[(size_t)(offset - start)], data, len);
+
+	m_pending.erase(first, last);
+	m_pending[start].swap(merged);
+}
+
+
+void BinaryWriter::Flush()
+{
+	if (!TryFlush())
+		WriteFailed();
+}
+
+
+bool BinaryWriter::TryFlush()
+{
+	if (m_pending.empty())
+		return true;
+
+	bool ok = true;
+	m_view->BeginUndoActions();
+	for (auto& i : m_pending)
+	{
+		if (m_view->Write(i.first, i.second.data(), i.second.size()) != i.second.size())
+			ok = false;
+	}
+	m_view->CommitUndoActions();
+	m_pending.clear();
+
+	if (!ok)
+		return RecordWriteFailure();
+	return true;
+}
+
+
+bool BinaryWriter::RecordWriteFailure()
+{
+	m_error = true;
+	m_skipWrites = m_stickyErrors;
+	return false;
+}
+
+
+void BinaryWriter::WriteFailed()
+{
+	if (!m_stickyErrors)
 		throw WriteException();
 }
 
 
+void BinaryWriter::Write(const void* src, size_t len)
+{
+	if (!TryWrite(src, len))
+		WriteFailed();
+}
+
+
 void BinaryWriter::Write(const DataBuffer& buf)
 {
 	Write(buf.GetData(), buf.GetLength());
@@ -70,77 +250,90 @@ void BinaryWriter::Write(const string& str)
 
 void BinaryWriter::Write8(uint8_t val)
 {
-	if (!BNWrite8(m_stream, val))
-		throw WriteException();
+	if (!TryWrite8(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::Write16(uint16_t val)
 {
-	if (!BNWrite16(m_stream, val))
-		throw WriteException();
+	if (!TryWrite16(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::Write32(uint32_t val)
 {
-	if (!BNWrite32(m_stream, val))
-		throw WriteException();
+	if (!TryWrite32(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::Write64(uint64_t val)
 {
-	if (!BNWrite64(m_stream, val))
-		throw WriteException();
+	if (!TryWrite64(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteLE16(uint16_t val)
 {
-	if (!BNWriteLE16(m_stream, val))
-		throw WriteException();
+	if (!TryWriteLE16(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteLE32(uint32_t val)
 {
-	if (!BNWriteLE32(m_stream, val))
-		throw WriteException();
+	if (!TryWriteLE32(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteLE64(uint64_t val)
 {
-	if (!BNWriteLE64(m_stream, val))
-		throw WriteException();
+	if (!TryWriteLE64(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteBE16(uint16_t val)
 {
-	if (!BNWriteBE16(m_stream, val))
-		throw WriteException();
+	if (!TryWriteBE16(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteBE32(uint32_t val)
 {
-	if (!BNWriteBE32(m_stream, val))
-		throw WriteException();
+	if (!TryWriteBE32(val))
+		WriteFailed();
 }
 
 
 void BinaryWriter::WriteBE64(uint64_t val)
 {
-	if (!BNWriteBE64(m_stream, val))
-		throw WriteException();
+	if (!TryWriteBE64(val))
+		WriteFailed();
 }
 
 
 bool BinaryWriter::TryWrite(const void* src, size_t len)
 {
-	return BNWriteData(m_stream, src, len);
+	if (m_skipWrites)
+		return false;
+
+	if (m_combining)
+	{
+		if (len != 0)
+			AddPendingWrite(m_offset, (const uint8_t*)src, len);
+		m_offset += len;
+		return true;
+	}
+
+	if (!BNWriteData(m_stream, src, len))
+		return RecordWriteFailure();
+	return true;
 }
 
 
@@ -158,77 +351,112 @@ bool BinaryWriter::TryWrite(const string& str)
 
 bool BinaryWriter::TryWrite8(uint8_t val)
 {
-	return BNWrite8(m_stream, val);
+	return TryWrite(&val, 1);
 }
 
 
 bool BinaryWriter::TryWrite16(uint16_t val)
 {
-	return BNWrite16(m_stream, val);
+	uint8_t data[2];
+	if (m_endian == LittleEndian)
+		EncodeLE16(data, val);
+	else
+		EncodeBE16(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWrite32(uint32_t val)
 {
-	return BNWrite32(m_stream, val);
+	uint8_t data[4];
+	if (m_endian == LittleEndian)
+		EncodeLE32(data, val);
+	else
+		EncodeBE32(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWrite64(uint64_t val)
 {
-	return BNWrite64(m_stream, val);
+	uint8_t data[8];
+	if (m_endian == LittleEndian)
+		EncodeLE64(data, val);
+	else
+		EncodeBE64(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWriteLE16(uint16_t val)
 {
-	return BNWriteLE16(m_stream, val);
+	uint8_t data[2];
+	EncodeLE16(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWriteLE32(uint32_t val)
 {
-	return BNWriteLE32(m_stream, val);
+	uint8_t data[4];
+	EncodeLE32(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWriteLE64(uint64_t val)
 {
-	return BNWriteLE64(m_stream, val);
+	uint8_t data[8];
+	EncodeLE64(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWriteBE16(uint16_t val)
 {
-	return BNWriteBE16(m_stream, val);
+	uint8_t data[2];
+	EncodeBE16(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWriteBE32(uint32_t val)
 {
-	return BNWriteBE32(m_stream, val);
+	uint8_t data[4];
+	EncodeBE32(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 bool BinaryWriter::TryWriteBE64(uint64_t val)
 {
-	return BNWriteBE64(m_stream, val);
+	uint8_t data[8];
+	EncodeBE64(data, val);
+	return TryWrite(data, sizeof(data));
 }
 
 
 uint64_t BinaryWriter::GetOffset() const
 {
+	if (m_combining)
+		return m_offset;
 	return BNGetWriterPosition(m_stream);
 }
 
 
 void BinaryWriter::Seek(uint64_t offset)
 {
-	BNSeekBinaryWriter(m_stream, offset);
+	if (m_combining)
+		m_offset = offset;
+	else
+		BNSeekBinaryWriter(m_stream, offset);
 }
 
 
 void BinaryWriter::SeekRelative(int64_t offset)
 {
-	BNSeekBinaryWriterRelative(m_stream, offset);
+	if (m_combining)
+		m_offset += offset;
+	else
+		BNSeekBinaryWriterRelative(m_stream, offset);
 }
@@ -0,0 +1,212 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include "binaryninjaapi.h"
+#include "simd.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+static const size_t NoAnchor = (size_t)-1;
+
+
+static int DecodePatternDigit(char ch)
+{
+	if ((ch >= '0') && (ch <= '9'))
+		return ch - '0';
+	if ((ch >= 'a') && (ch <= 'f'))
+		return ch - 'a' + 10;
+	if ((ch >= 'A') && (ch <= 'F'))
+		return ch - 'A' + 10;
+	return -1;
+}
+
+
+static bool IsPatternSpace(char ch)
+{
+	return (ch == ' ') || (ch == '\t') || (ch == '\r') || (ch == '\n');
+}
+
+
+BytePattern::BytePattern(): m_firstAnchor(NoAnchor), m_secondAnchor(NoAnchor)
+{
+}
+
+
+BytePattern::BytePattern(const vector<uint8_t>& bytes): m_bytes(bytes), m_mask(bytes.size(), 0xff)
+{
+	ChooseAnchors();
+}
+
+
+BytePattern::BytePattern(const vector<uint8_t>& bytes, const vector<uint8_t>& mask): m_bytes(bytes), m_mask(mask)
+{
+	m_mask.resize(m_bytes.size(), 0xff);
+	for (size_t i = 0; i < m_bytes.size(); i++)
+		m_bytes[i] &= m_mask[i];
+	ChooseAnchors();
+}
+
+
+void BytePattern::ChooseAnchors()
+{
+	// The search filters candidates on two pattern bytes at once. Fully specified bytes are the
+	// most selective, and bytes that are common in code and padding make poor filters.
+	int bestScore[2] = {0, 0};
+	m_firstAnchor = NoAnchor;
+	m_secondAnchor = NoAnchor;
+	for (size_t i = 0; i < m_bytes.size(); i++)
+	{
+		if (m_mask[i] == 0)
+			continue;
+		int score = 2;
+		if (m_mask[i] == 0xff)
+		{
+			uint8_t value = m_bytes[i];
+			bool common = (value == 0x00) || (value == 0xff) || (value == 0xcc) || (value == 0x90);
+			score = common ? 3 : 4;
+		}
+
+		if (score > bestScore[0])
+		{
+			bestScore[1] = bestScore[0];
+			m_secondAnchor = m_firstAnchor;
+			bestScore[0] = score;
+			m_firstAnchor = i;
+		}
+		else if (score > bestScore[1])
+		{
+			bestScore[1] = score;
+			m_secondAnchor = i;
+		}
+	}
+}
+
+
+bool BytePattern::Parse(const string& text, BytePattern& result)
+{
+	vector<uint8_t> bytes, mask;
+	size_t i = 0;
+	while (i < text.size())
+	{
+		if (IsPatternSpace(text[i]))
+		{
+			i++;
+			continue;
+		}
+
+		if ((text[i] == '?') && (((i + 1) == text.size()) || IsPatternSpace(text[i + 1])))
+		{
+			bytes.push_back(0);
+			mask.push_back(0);
+			i++;
+			continue;
+		}
+
+		if ((i + 1) >= text.size())
+			return false;
+		uint8_t value = 0;
+		uint8_t valueMask = 0;
+		for (size_t j = 0; j < 2; j++)
+		{
+			value <<= 4;
+			valueMask <<= 4;
+			if (text[i + j] == '?')
+				continue;
+			int digit = DecodePatternDigit(text[i + j]);
+			if (digit < 0)
+				return false;
+			value |= (uint8_t)digit;
+			valueMask |= 0xf;
+		}
+		bytes.push_back(value);
+		mask.push_back(valueMask);
+		i += 2;
+	}
+
+	if (bytes.empty())
+		return false;
+	result = BytePattern(bytes, mask);
+	return true;
+}
+
+
+bool BytePattern::Matches(const uint8_t* data) const
+{
+	for (size_t i = 0; i < m_bytes.size(); i++)
+	{
+		if ((data[i] & m_mask[i]) != m_bytes[i])
+			return false;
+	}
+	return true;
+}
+
+
+bool BytePattern::Find(const uint8_t* data, size_t len, size_t start, size_t& result) const
+{
+	size_t patternLen = m_bytes.size();
+	if ((patternLen == 0) || (len < patternLen) || (start > (len - patternLen)))
+		return false;
+	size_t last = len - patternLen;
+	size_t i = start;
+
+#ifdef BN_SIMD_SSE2
+	if (m_firstAnchor != NoAnchor)
+	{
+		// Compare the anchor bytes of 16 candidate positions at a time and only verify the full
+		// pattern where both match. Anchors lie within the pattern, so every load stays in bounds.
+		size_t secondAnchor = (m_secondAnchor != NoAnchor) ? m_secondAnchor : m_firstAnchor;
+		__m128i firstMask = _mm_set1_epi8((char)m_mask[m_firstAnchor]);
+		__m128i firstValue = _mm_set1_epi8((char)m_bytes[m_firstAnchor]);
+		__m128i secondMask = _mm_set1_epi8((char)m_mask[secondAnchor]);
+		__m128i secondValue = _mm_set1_epi8((char)m_bytes[secondAnchor]);
+		for (; (i + 15) <= last; i += 16)
+		{
+			__m128i first = _mm_loadu_si128((const __m128i*)(data + i + m_firstAnchor));
+			__m128i second = _mm_loadu_si128((const __m128i*)(data + i + secondAnchor));
+			__m128i hits = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(first, firstMask), firstValue),
+				_mm_cmpeq_epi8(_mm_and_si128(second, secondMask), secondValue));
+			uint32_t candidates = (uint32_t)_mm_movemask_epi8(hits);
+			while (candidates)
+			{
+				size_t pos = i + Simd::CountTrailingZeros(candidates);
+				if (Matches(data + pos))
+				{
+					result = pos;
+					return true;
+				}
+				candidates &= candidates - 1;
+			}
+		}
+	}
+#endif
+
+	for (; i <= last; i++)
+	{
+		if (Matches(data + i))
+		{
+			result = i;
+			return true;
+		}
+	}
+	return false;
+}
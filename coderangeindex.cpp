@@ -0,0 +1,349 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+CodeRangeIndex::CodeRangeIndex(BinaryView* view): m_view(view), m_rootLevel(0), m_rebuild(false)
+{
+	m_view->RegisterNotification(this);
+	Refresh();
+}
+
+
+CodeRangeIndex::~CodeRangeIndex()
+{
+	m_view->UnregisterNotification(this);
+}
+
+
+CodeRangeIndex::FunctionBlocks CodeRangeIndex::GetFunctionBlocks(Function* func)
+{
+	FunctionBlocks result;
+	result.function = func;
+	result.blocks = func->GetBasicBlocks();
+	return result;
+}
+
+
+void CodeRangeIndex::Refresh()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	// Updates queued before this point are covered by the new function list. Updates that arrive while
+	// it is being fetched stay queued and are applied on the next lookup.
+	{
+		lock_guard<mutex> pendingLock(m_pendingMutex);
+		m_pending.clear();
+	}
+
+	m_functions.clear();
+	for (auto& i : m_view->GetAnalysisFunctionList())
+		m_functions[i->GetObject()] = GetFunctionBlocks(i);
+	m_rebuild = true;
+	Update();
+}
+
+
+void CodeRangeIndex::AddPendingUpdate(Function* func, bool removed)
+{
+	PendingUpdate update;
+	update.function = func;
+	update.removed = removed;
+
+	lock_guard<mutex> lock(m_pendingMutex);
+	m_pending[func->GetObject()] = update;
+}
+
+
+static bool CompareRangeStart(const CodeRange& a, const CodeRange& b)
+{
+	return a.start < b.start;
+}
+
+
+void CodeRangeIndex::AddRanges(const FunctionBlocks& blocks, vector<CodeRange>& ranges)
+{
+	for (auto& i : blocks.blocks)
+	{
+		CodeRange range;
+		range.start = i->GetStart();
+		range.end = i->GetEnd();
+		range.function = blocks.function;
+		range.block = i;
+		if (range.end > range.start)
+			ranges.push_back(range);
+	}
+}
+
+
+void CodeRangeIndex::Update()
+{
+	// Notifications only take the pending lock, so analysis is never blocked behind a rebuild
+	map<BNFunction*, PendingUpdate> pending;
+	{
+		lock_guard<mutex> lock(m_pendingMutex);
+		pending.swap(m_pending);
+	}
+
+	if (pending.empty() && !m_rebuild)
+		return;
+
+	if (m_rebuild)
+	{
+		for (auto& i : pending)
+		{
+			if (i.second.removed)
+				m_functions.erase(i.first);
+			else
+				m_functions[i.first] = GetFunctionBlocks(i.second.function);
+		}
+
+		m_ranges.clear();
+		for (auto& i : m_functions)
+			AddRanges(i.second, m_ranges);
+		sort(m_ranges.begin(), m_ranges.end(), CompareRangeStart);
+		m_rebuild = false;
+		UpdateMaxEnd(0);
+		return;
+	}
+
+	// Only the changed functions are refetched. Their old ranges are found from the blocks already
+	// held for them and dropped before those are released, and the new ranges are merged into the
+	// sorted array. Ranges before the first change keep their place, so their part of the tree is
+	// left alone.
+	size_t firstChanged = m_ranges.size();
+	for (auto& i : pending)
+	{
+		auto existing = m_functions.find(i.first);
+		if (existing == m_functions.end())
+			continue;
+		for (auto& j : existing->second.blocks)
+		{
+			CodeRange key;
+			key.start = j->GetStart();
+			for (auto k = lower_bound(m_ranges.begin(), m_ranges.end(), key, CompareRangeStart);
+				(k != m_ranges.end()) && (k->start == key.start); ++k)
+			{
+				if (k->block == j)
+				{
+					k->block = nullptr;
+					firstChanged = min(firstChanged, (size_t)(k - m_ranges.begin()));
+				}
+			}
+		}
+	}
+	m_ranges.erase(remove_if(m_ranges.begin() + firstChanged, m_ranges.end(),
+		[](const CodeRange& range) { return range.block == nullptr; }), m_ranges.end());
+
+	vector<CodeRange> added;
+	for (auto& i : pending)
+	{
+		if (i.second.removed)
+		{
+			m_functions.erase(i.first);
+			continue;
+		}
+		FunctionBlocks& blocks = m_functions[i.first];
+		blocks = GetFunctionBlocks(i.second.function);
+		AddRanges(blocks, added);
+	}
+	sort(added.begin(), added.end(), CompareRangeStart);
+
+	// Merge from the back so that only the ranges after the first insertion point move
+	size_t read = m_ranges.size();
+	size_t write = read + added.size();
+	m_ranges.resize(write);
+	for (size_t i = added.size(); i > 0; )
+	{
+		if ((read > 0) && CompareRangeStart(added[i - 1], m_ranges[read - 1]))
+			m_ranges[--write] = m_ranges[--read];
+		else
+			m_ranges[--write] = added[--i];
+	}
+	UpdateMaxEnd(min(firstChanged, write));
+}
+
+
+void CodeRangeIndex::UpdateMaxEnd(size_t first)
+{
+	// The sorted array doubles as an implicit binary tree. The node at index i is at the level given by
+	// the number of trailing one bits of i, its children are at i - 2^(level - 1) and i + 2^(level - 1),
+	// and m_maxEnd[i] is the largest end in its subtree. Children past the end of the array stand for
+	// the last subtree that does exist. Only nodes whose subtree reaches first or later are recomputed.
+	size_t count = m_ranges.size();
+	m_maxEnd.resize(count);
+	m_rootLevel = 0;
+	if (count == 0)
+		return;
+
+	for (size_t i = first & ~(size_t)1; i < count; i += 2)
+		m_maxEnd[i] = m_ranges[i].end;
+	size_t lastIndex = (count - 1) & ~(size_t)1;
+	uint64_t lastEnd = m_ranges[lastIndex].end;
+
+	size_t level;
+	for (level = 1; ((size_t)1 << level) <= count; level++)
+	{
+		size_t half = (size_t)1 << (level - 1);
+		size_t base = (half << 1) - 1;
+		size_t step = half << 2;
+		size_t start = base;
+		if (first > (base << 1))
+			start += ((first - (base << 1) + step - 1) / step) * step;
+		for (size_t i = start; i < count; i += step)
+		{
+			uint64_t left = m_maxEnd[i - half];
+			uint64_t right = ((i + half) < count) ? m_maxEnd[i + half] : lastEnd;
+			m_maxEnd[i] = max(m_ranges[i].end, max(left, right));
+		}
+
+		// Move to the parent of the last node, which may lie past the end of the array
+		lastIndex = ((lastIndex >> level) & 1) ? (lastIndex - half) : (lastIndex + half);
+		if ((lastIndex < count) && (m_maxEnd[lastIndex] > lastEnd))
+			lastEnd = m_maxEnd[lastIndex];
+	}
+	m_rootLevel = level - 1;
+}
+
+
+size_t CodeRangeIndex::GetFunctionCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+	return m_functions.size();
+}
+
+
+size_t CodeRangeIndex::GetBlockCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+	return m_ranges.size();
+}
+
+
+template <typename T>
+static bool ForEachContainingRange(const vector<CodeRange>& ranges, const vector<uint64_t>& maxEnd, size_t rootLevel,
+	uint64_t addr, const T& callback)
+{
+	struct Node
+	{
+		size_t index;
+		size_t level;
+		bool leftDone;
+	};
+
+	size_t count = ranges.size();
+	if (count == 0)
+		return true;
+
+	// Subtrees whose largest end is at or before addr are skipped, and so are right subtrees once a
+	// node starts after addr, so a lookup visits a logarithmic number of nodes plus the matches
+	Node stack[128];
+	size_t depth = 0;
+	stack[depth++] = Node {((size_t)1 << rootLevel) - 1, rootLevel, false};
+	while (depth > 0)
+	{
+		Node node = stack[--depth];
+		if (node.level <= 3)
+		{
+			// Small subtrees are scanned directly
+			size_t first = (node.index >> node.level) << node.level;
+			size_t last = min(first + ((size_t)1 << (node.level + 1)) - 1, count);
+			for (size_t i = first; (i < last) && (ranges[i].start <= addr); i++)
+			{
+				if ((ranges[i].end > addr) && !callback(ranges[i]))
+					return false;
+			}
+		}
+		else if (!node.leftDone)
+		{
+			size_t left = node.index - ((size_t)1 << (node.level - 1));
+			node.leftDone = true;
+			stack[depth++] = node;
+			if ((left >= count) || (maxEnd[left] > addr))
+				stack[depth++] = Node {left, node.level - 1, false};
+		}
+		else if ((node.index < count) && (ranges[node.index].start <= addr))
+		{
+			if ((ranges[node.index].end > addr) && !callback(ranges[node.index]))
+				return false;
+			stack[depth++] = Node {node.index + ((size_t)1 << (node.level - 1)), node.level - 1, false};
+		}
+	}
+	return true;
+}
+
+
+size_t CodeRangeIndex::GetRangesForAddress(uint64_t addr, CodeRange* results, size_t maxCount)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+
+	size_t count = 0;
+	ForEachContainingRange(m_ranges, m_maxEnd, m_rootLevel, addr, [&](const CodeRange& range) {
+		if (count < maxCount)
+			results[count] = range;
+		count++;
+		return true;
+	});
+	return count;
+}
+
+
+void CodeRangeIndex::ForEachRangeForAddress(uint64_t addr, const function<bool(const CodeRange& range)>& callback)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+	ForEachContainingRange(m_ranges, m_maxEnd, m_rootLevel, addr, callback);
+}
+
+
+bool CodeRangeIndex::IsCodeAddress(uint64_t addr)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+	return !ForEachContainingRange(m_ranges, m_maxEnd, m_rootLevel, addr, [](const CodeRange&) { return false; });
+}
+
+
+void CodeRangeIndex::OnAnalysisFunctionAdded(BinaryView*, Function* func)
+{
+	AddPendingUpdate(func, false);
+}
+
+
+void CodeRangeIndex::OnAnalysisFunctionRemoved(BinaryView*, Function* func)
+{
+	AddPendingUpdate(func, true);
+}
+
+
+void CodeRangeIndex::OnAnalysisFunctionUpdated(BinaryView*, Function* func)
+{
+	AddPendingUpdate(func, false);
+}
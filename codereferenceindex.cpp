@@ -0,0 +1,297 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+CodeReferenceIndex::CodeReferenceIndex(BinaryView* view): m_view(view), m_rebuild(false)
+{
+	m_view->RegisterNotification(this);
+	Refresh();
+}
+
+
+CodeReferenceIndex::~CodeReferenceIndex()
+{
+	m_view->UnregisterNotification(this);
+}
+
+
+static bool CompareReferences(const CodeReference& a, const CodeReference& b)
+{
+	if (a.target != b.target)
+		return a.target < b.target;
+	if (a.source != b.source)
+		return a.source < b.source;
+	return a.function < b.function;
+}
+
+
+CodeReferenceIndex::FunctionReferences CodeReferenceIndex::GetFunctionReferences(Function* func)
+{
+	FunctionReferences result;
+	result.function = func;
+	uint64_t funcStart = func->GetStart();
+
+	vector<uint8_t> data;
+	for (auto& block : func->GetBasicBlocks())
+	{
+		uint64_t start = block->GetStart();
+		uint64_t end = block->GetEnd();
+		if (end <= start)
+			continue;
+		Ref<Architecture> arch = block->GetArchitecture();
+		data.resize((size_t)(end - start));
+		size_t len = m_view->Read(&data[0], start, data.size());
+
+		for (size_t offset = 0; offset < len; )
+		{
+			InstructionInfo info;
+			if (!arch->GetInstructionInfo(&data[offset], start + offset, len - offset, info) || (info.length == 0))
+				break;
+
+			for (size_t i = 0; i < info.branchCount; i++)
+			{
+				// Only calls are kept, so branch targets inside a function never show up as references
+				if (info.branchType[i] != CallDestination)
+					continue;
+
+				CodeReference ref;
+				ref.target = info.branchTarget[i];
+				ref.source = start + offset;
+				ref.function = funcStart;
+				result.refs.push_back(ref);
+			}
+			offset += info.length;
+		}
+	}
+	sort(result.refs.begin(), result.refs.end(), CompareReferences);
+	return result;
+}
+
+
+void CodeReferenceIndex::Refresh()
+{
+	lock_guard<mutex> lock(m_mutex);
+
+	// Updates queued before this point are covered by decoding every function. Updates that arrive
+	// while that is running stay queued and are applied on the next query.
+	{
+		lock_guard<mutex> pendingLock(m_pendingMutex);
+		m_pending.clear();
+	}
+
+	m_functions.clear();
+	for (auto& i : m_view->GetAnalysisFunctionList())
+		m_functions[i->GetObject()] = GetFunctionReferences(i);
+	m_rebuild = true;
+	Update();
+}
+
+
+void CodeReferenceIndex::AddPendingUpdate(Function* func, bool removed)
+{
+	PendingUpdate update;
+	update.function = func;
+	update.removed = removed;
+
+	lock_guard<mutex> lock(m_pendingMutex);
+	m_pending[func->GetObject()] = update;
+}
+
+
+void CodeReferenceIndex::Update()
+{
+	map<BNFunction*, PendingUpdate> pending;
+	{
+		lock_guard<mutex> lock(m_pendingMutex);
+		pending.swap(m_pending);
+	}
+
+	if (m_rebuild)
+	{
+		for (auto& i : pending)
+		{
+			if (i.second.removed)
+				m_functions.erase(i.first);
+			else
+				m_functions[i.first] = GetFunctionReferences(i.second.function);
+		}
+
+		m_refs.clear();
+		for (auto& i : m_functions)
+			m_refs.insert(m_refs.end(), i.second.refs.begin(), i.second.refs.end());
+		sort(m_refs.begin(), m_refs.end(), CompareReferences);
+		m_rebuild = false;
+		return;
+	}
+
+	if (pending.empty())
+		return;
+
+	// Only the changed functions are decoded again. Their old references are looked up in the sorted
+	// array and dropped, and their new ones, kept sorted per function, are merged in.
+	vector<bool> removed(m_refs.size(), false);
+	size_t firstRemoved = m_refs.size();
+	vector<CodeReference> added;
+	for (auto& i : pending)
+	{
+		auto existing = m_functions.find(i.first);
+		if (existing != m_functions.end())
+		{
+			for (auto& j : existing->second.refs)
+			{
+				auto range = equal_range(m_refs.begin(), m_refs.end(), j, CompareReferences);
+				for (auto k = range.first; k != range.second; ++k)
+				{
+					size_t index = (size_t)(k - m_refs.begin());
+					if (!removed[index])
+					{
+						removed[index] = true;
+						firstRemoved = min(firstRemoved, index);
+						break;
+					}
+				}
+			}
+		}
+
+		if (i.second.removed)
+		{
+			if (existing != m_functions.end())
+				m_functions.erase(existing);
+			continue;
+		}
+		FunctionReferences& refs = m_functions[i.first];
+		refs = GetFunctionReferences(i.second.function);
+		size_t middle = added.size();
+		added.insert(added.end(), refs.refs.begin(), refs.refs.end());
+		inplace_merge(added.begin(), added.begin() + middle, added.end(), CompareReferences);
+	}
+
+	size_t write = firstRemoved;
+	for (size_t i = firstRemoved; i < m_refs.size(); i++)
+	{
+		if (!removed[i])
+			m_refs[write++] = m_refs[i];
+	}
+	m_refs.resize(write);
+
+	// Merge from the back so that only the references after the first insertion point move
+	size_t read = m_refs.size();
+	write = read + added.size();
+	m_refs.resize(write);
+	for (size_t i = added.size(); i > 0; )
+	{
+		if ((read > 0) && CompareReferences(added[i - 1], m_refs[read - 1]))
+			m_refs[--write] = m_refs[--read];
+		else
+			m_refs[--write] = added[--i];
+	}
+}
+
+
+static vector<CodeReference>::const_iterator FindFirstReference(const vector<CodeReference>& refs, uint64_t target)
+{
+	return lower_bound(refs.begin(), refs.end(), target,
+		[](const CodeReference& ref, uint64_t value) { return ref.target < value; });
+}
+
+
+size_t CodeReferenceIndex::GetReferenceCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+	return m_refs.size();
+}
+
+
+size_t CodeReferenceIndex::GetReferenceCount(uint64_t target)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+	size_t count = 0;
+	for (auto i = FindFirstReference(m_refs, target); (i != m_refs.end()) && (i->target == target); ++i)
+		count++;
+	return count;
+}
+
+
+void CodeReferenceIndex::ForEachReference(uint64_t target, const function<bool(const CodeReference& ref)>& callback)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+	for (auto i = FindFirstReference(m_refs, target); (i != m_refs.end()) && (i->target == target); ++i)
+	{
+		if (!callback(*i))
+			break;
+	}
+}
+
+
+void CodeReferenceIndex::GetReferences(const vector<uint64_t>& targets, CodeReferenceTable& result)
+{
+	result.Clear();
+	result.targets = targets;
+	sort(result.targets.begin(), result.targets.end());
+	result.targets.erase(unique(result.targets.begin(), result.targets.end()), result.targets.end());
+
+	lock_guard<mutex> lock(m_mutex);
+	Update();
+
+	// Both lists are sorted by target, so a single merge pass collects every target's references
+	result.offsets.reserve(result.targets.size() + 1);
+	result.offsets.push_back(0);
+	vector<CodeReference>::const_iterator ref = m_refs.begin();
+	for (auto target : result.targets)
+	{
+		if ((ref != m_refs.end()) && (ref->target < target))
+			ref = FindFirstReference(m_refs, target);
+		for (; (ref != m_refs.end()) && (ref->target == target); ++ref)
+		{
+			result.sources.push_back(ref->source);
+			result.functions.push_back(ref->function);
+		}
+		result.offsets.push_back(result.sources.size());
+	}
+}
+
+
+void CodeReferenceIndex::OnAnalysisFunctionAdded(BinaryView*, Function* func)
+{
+	AddPendingUpdate(func, false);
+}
+
+
+void CodeReferenceIndex::OnAnalysisFunctionRemoved(BinaryView*, Function* func)
+{
+	AddPendingUpdate(func, true);
+}
+
+
+void CodeReferenceIndex::OnAnalysisFunctionUpdated(BinaryView*, Function* func)
+{
+	AddPendingUpdate(func, false);
+}
@@ -18,33 +18,395 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <string.h>
 #include "binaryninjaapi.h"
+#include "simd.h"
 
 using namespace BinaryNinja;
 using namespace std;
 
 
+static const char g_base64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char g_hexDigitsLower[] = "0123456789abcdef";
+static const char g_hexDigitsUpper[] = "0123456789ABCDEF";
+
+
+struct Base64DecodeTable
+{
+	int8_t values[256];
+
+	Base64DecodeTable()
+	{
+		memset(values, -1, sizeof(values));
+		for (int i = 0; i < 64; i++)
+			values[(uint8_t)g_base64Alphabet[i]] = (int8_t)i;
+	}
+};
+
+
+static int8_t DecodeBase64Char(uint8_t ch)
+{
+	static const Base64DecodeTable table;
+	return table.values[ch];
+}
+
+
+static int8_t DecodeHexDigit(uint8_t ch)
+{
+	if ((ch >= '0') && (ch <= '9'))
+		return (int8_t)(ch - '0');
+	ch |= 0x20;
+	if ((ch >= 'a') && (ch <= 'f'))
+		return (int8_t)(ch - 'a' + 10);
+	return -1;
+}
+
+
+// Bytes that are copied through unchanged by the escaped string format. Anything else is left to
+// the core so the output stays identical to BNDataBufferToEscapedString.
+static inline bool IsPlainEscapedChar(uint8_t ch)
+{
+	return (ch >= 0x20) && (ch < 0x7f) && (ch != '\\') && (ch != '"') && (ch != '\'');
+}
+
+
+static bool IsPlainEscapedString(const uint8_t* data, size_t len)
+{
+	size_t i = 0;
+#ifdef BN_SIMD_SSE2
+	const __m128i lowLimit = _mm_set1_epi8(0x1f);
+	const __m128i highLimit = _mm_set1_epi8(0x7f);
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i doubleQuote = _mm_set1_epi8('"');
+	const __m128i singleQuote = _mm_set1_epi8('\'');
+	for (; (i + 16) <= len; i += 16)
+	{
+		// Signed compares also reject bytes 0x80 and above, which are negative
+		__m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i plain = _mm_and_si128(_mm_cmpgt_epi8(block, lowLimit), _mm_cmplt_epi8(block, highLimit));
+		__m128i special = _mm_or_si128(_mm_cmpeq_epi8(block, backslash),
+			_mm_or_si128(_mm_cmpeq_epi8(block, doubleQuote), _mm_cmpeq_epi8(block, singleQuote)));
+		if (_mm_movemask_epi8(_mm_andnot_si128(special, plain)) != 0xffff)
+			return false;
+	}
+#endif
+	for (; i < len; i++)
+	{
+		if (!IsPlainEscapedChar(data[i]))
+			return false;
+	}
+	return true;
+}
+
+
+#ifdef BN_SIMD_X86
+// Encodes 12 input bytes per iteration into 16 output characters. Reads 16 bytes per block, so it
+// stops while at least 4 bytes of input remain past the block.
+BN_SIMD_TARGET("ssse3")
+static void EncodeBase64SSSE3(const uint8_t* src, size_t len, char* dest, size_t& srcPos, size_t& destPos)
+{
+	const __m128i splitShuffle = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+	const __m128i shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	size_t i = srcPos;
+	size_t j = destPos;
+	for (; (i + 16) <= len; i += 12, j += 16)
+	{
+		__m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i)), splitShuffle);
+
+		// Move each 6-bit group into its own byte
+		__m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+		__m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+		__m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+		__m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+		__m128i indices = _mm_or_si128(t1, t3);
+
+		// Map 0-63 onto the alphabet by adding a per-range offset
+		__m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+		__m128i lessThan26 = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+		reduced = _mm_or_si128(reduced, _mm_and_si128(lessThan26, _mm_set1_epi8(13)));
+		__m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shiftLut, reduced), indices);
+		_mm_storeu_si128((__m128i*)(dest + j), chars);
+	}
+	srcPos = i;
+	destPos = j;
+}
+
+
+// Decodes 16 characters per iteration into 12 output bytes, writing 16 bytes per block. Stops at the
+// first block containing a character outside the alphabet and leaves it for the scalar decoder.
+BN_SIMD_TARGET("ssse3")
+static void DecodeBase64SSSE3(const char* src, size_t len, uint8_t* dest, size_t& srcPos, size_t& destPos)
+{
+	const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+		0x1b, 0x1b, 0x1b, 0x1a);
+	const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+		0x10, 0x10, 0x10, 0x10);
+	const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i mask2F = _mm_set1_epi8(0x2f);
+	const __m128i packShuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+	size_t i = srcPos;
+	size_t j = destPos;
+	for (; (i + 16) <= len; i += 16, j += 12)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+		__m128i loNibbles = _mm_and_si128(in, mask2F);
+		__m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+		__m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff)
+			break;
+
+		__m128i isSlash = _mm_cmpeq_epi8(in, mask2F);
+		__m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(isSlash, hiNibbles));
+		__m128i values = _mm_add_epi8(in, roll);
+
+		// Pack four 6-bit values per 32-bit lane into three bytes
+		__m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+		__m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+		_mm_storeu_si128((__m128i*)(dest + j), _mm_shuffle_epi8(packed, packShuffle));
+	}
+	srcPos = i;
+	destPos = j;
+}
+
+
+BN_SIMD_TARGET("ssse3")
+static void EncodeHexSSSE3(const uint8_t* src, size_t len, char* dest, const char* digits, size_t& pos)
+{
+	const __m128i lut = _mm_loadu_si128((const __m128i*)digits);
+	const __m128i lowMask = _mm_set1_epi8(0x0f);
+
+	size_t i = pos;
+	for (; (i + 16) <= len; i += 16)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(in, 4), lowMask));
+		__m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(in, lowMask));
+		_mm_storeu_si128((__m128i*)(dest + (i * 2)), _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i*)(dest + (i * 2) + 16), _mm_unpackhi_epi8(hi, lo));
+	}
+	pos = i;
+}
+
+
+// Decodes 16 hex digits per iteration into 8 bytes. Returns false on the first invalid digit.
+BN_SIMD_TARGET("ssse3")
+static bool DecodeHexSSSE3(const char* src, size_t len, uint8_t* dest, size_t& pos)
+{
+	const __m128i zeroChar = _mm_set1_epi8('0');
+	const __m128i lowerA = _mm_set1_epi8('a');
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	const __m128i nine = _mm_set1_epi8(9);
+	const __m128i five = _mm_set1_epi8(5);
+	const __m128i ten = _mm_set1_epi8(10);
+	const __m128i weights = _mm_set1_epi16(0x0110);
+
+	size_t i = pos;
+	for (; (i + 16) <= len; i += 16)
+	{
+		__m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+		__m128i digit = _mm_sub_epi8(in, zeroChar);
+		__m128i alpha = _mm_sub_epi8(_mm_or_si128(in, caseBit), lowerA);
+		__m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, nine), digit);
+		__m128i isAlpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, five), alpha);
+		if (_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha)) != 0xffff)
+		{
+			pos = i;
+			return false;
+		}
+
+		__m128i values = _mm_or_si128(_mm_and_si128(isDigit, digit),
+			_mm_and_si128(isAlpha, _mm_add_epi8(alpha, ten)));
+		__m128i pairs = _mm_maddubs_epi16(values, weights);
+		_mm_storel_epi64((__m128i*)(dest + (i / 2)), _mm_packus_epi16(pairs, pairs));
+	}
+	pos = i;
+	return true;
+}
+#endif
+
+
+static thread_local DataBufferArena* t_currentArena = nullptr;
+
+
+static size_t GetSizeClassShift(size_t len)
+{
+	size_t shift = 0;
+	while ((shift < 63) && (((size_t)1 << shift) < len))
+		shift++;
+	return shift;
+}
+
+
+DataBufferArena::DataBufferArena(size_t maxCachedBytes): m_maxCachedBytes(maxCachedBytes), m_cachedBytes(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_previous = t_currentArena;
+	t_currentArena = this;
+}
+
+
+DataBufferArena::~DataBufferArena()
+{
+	Trim();
+	t_currentArena = m_previous;
+}
+
+
+DataBufferArena* DataBufferArena::GetCurrent()
+{
+	return t_currentArena;
+}
+
+
+size_t DataBufferArena::GetCachedBufferCount() const
+{
+	size_t count = 0;
+	for (size_t i = 0; i < SizeClassCount; i++)
+		count += m_free[i].size();
+	return count;
+}
+
+
+void DataBufferArena::Trim()
+{
+	for (size_t i = 0; i < SizeClassCount; i++)
+	{
+		for (auto buf : m_free[i])
+			BNFreeDataBuffer(buf);
+		m_free[i].clear();
+	}
+	m_cachedBytes = 0;
+}
+
+
+BNDataBuffer* DataBufferArena::Acquire(size_t len)
+{
+	// A buffer from class n was allocated with 2^n bytes, so resizing it to anything up to that
+	// length does not need to allocate
+	size_t shift = GetSizeClassShift(len);
+	if (shift < MinSizeClass)
+		shift = MinSizeClass;
+	if (shift <= MaxSizeClass)
+	{
+		vector<BNDataBuffer*>& freeList = m_free[shift - MinSizeClass];
+		if (!freeList.empty())
+		{
+			BNDataBuffer* buf = freeList.back();
+			freeList.pop_back();
+			m_cachedBytes -= (size_t)1 << shift;
+			m_owned[buf] = shift;
+			BNSetDataBufferLength(buf, len);
+			m_stats.reused++;
+			return buf;
+		}
+	}
+
+	m_stats.allocated++;
+
+	// Entries for buffers destroyed on other threads are never removed, so stop tracking new
+	// buffers once there are too many rather than letting the table grow without bound
+	if ((shift > MaxSizeClass) || (m_owned.size() >= MaxTrackedBuffers))
+		return BNCreateDataBuffer(nullptr, len);
+
+	// Allocate the full class size up front so the buffer can be filed under this class when
+	// it comes back
+	BNDataBuffer* buf = BNCreateDataBuffer(nullptr, (size_t)1 << shift);
+	BNSetDataBufferLength(buf, len);
+	m_owned[buf] = shift;
+	return buf;
+}
+
+
+bool DataBufferArena::Recycle(BNDataBuffer* buf, size_t shift)
+{
+	// The storage of a buffer that grew past its class is unknown, so it is not reused
+	size_t classBytes = (size_t)1 << shift;
+	if (BNGetDataBufferLength(buf) > classBytes)
+		return false;
+	if ((m_cachedBytes + classBytes) > m_maxCachedBytes)
+		return false;
+
+	m_free[shift - MinSizeClass].push_back(buf);
+	m_cachedBytes += classBytes;
+	m_stats.recycled++;
+	return true;
+}
+
+
+BNDataBuffer* DataBufferArena::CreateBuffer(const void* data, size_t len)
+{
+	DataBufferArena* arena = t_currentArena;
+	if (!arena)
+		return BNCreateDataBuffer(data, len);
+
+	BNDataBuffer* buf = arena->Acquire(len);
+	if (data && len)
+		memcpy(BNGetDataBufferContents(buf), data, len);
+	else if (len)
+		memset(BNGetDataBufferContents(buf), 0, len);
+	return buf;
+}
+
+
+void DataBufferArena::FreeBuffer(BNDataBuffer* buf)
+{
+	if (!buf)
+		return;
+
+	// Only buffers allocated by an arena on this thread are known to have class sized storage
+	for (DataBufferArena* arena = t_currentArena; arena; arena = arena->m_previous)
+	{
+		auto i = arena->m_owned.find(buf);
+		if (i == arena->m_owned.end())
+			continue;
+		size_t shift = i->second;
+		arena->m_owned.erase(i);
+		if (arena->Recycle(buf, shift))
+			return;
+		break;
+	}
+
+	if (t_currentArena)
+		t_currentArena->m_stats.freed++;
+	BNFreeDataBuffer(buf);
+}
+
+
 DataBuffer::DataBuffer()
 {
-	m_buffer = BNCreateDataBuffer(nullptr, 0);
+	m_buffer = DataBufferArena::CreateBuffer(nullptr, 0);
 }
 
 
 DataBuffer::DataBuffer(size_t len)
 {
-	m_buffer = BNCreateDataBuffer(nullptr, len);
+	m_buffer = DataBufferArena::CreateBuffer(nullptr, len);
 }
 
 
 DataBuffer::DataBuffer(const void* data, size_t len)
 {
-	m_buffer = BNCreateDataBuffer(data, len);
+	m_buffer = DataBufferArena::CreateBuffer(data, len);
 }
 
 
 DataBuffer::DataBuffer(const DataBuffer& buf)
 {
-	m_buffer = BNDuplicateDataBuffer(buf.m_buffer);
+	if (DataBufferArena::GetCurrent())
+		m_buffer = DataBufferArena::CreateBuffer(buf.GetData(), buf.GetLength());
+	else
+		m_buffer = BNDuplicateDataBuffer(buf.m_buffer);
+}
+
+
+DataBuffer::DataBuffer(DataBuffer&& buf) NOEXCEPT
+{
+	m_buffer = buf.m_buffer;
+	buf.m_buffer = nullptr;
 }
 
 
@@ -56,14 +418,30 @@ DataBuffer::DataBuffer(BNDataBuffer* buf)
 
 DataBuffer::~DataBuffer()
 {
-	BNFreeDataBuffer(m_buffer);
+	DataBufferArena::FreeBuffer(m_buffer);
 }
 
 
 DataBuffer& DataBuffer::operator=(const DataBuffer& buf)
 {
-	BNFreeDataBuffer(m_buffer);
-	m_buffer = BNDuplicateDataBuffer(buf.m_buffer);
+	if (this == &buf)
+		return *this;
+	DataBufferArena::FreeBuffer(m_buffer);
+	if (DataBufferArena::GetCurrent())
+		m_buffer = DataBufferArena::CreateBuffer(buf.GetData(), buf.GetLength());
+	else
+		m_buffer = BNDuplicateDataBuffer(buf.m_buffer);
+	return *this;
+}
+
+
+DataBuffer& DataBuffer::operator=(DataBuffer&& buf) NOEXCEPT
+{
+	if (this == &buf)
+		return *this;
+	DataBufferArena::FreeBuffer(m_buffer);
+	m_buffer = buf.m_buffer;
+	buf.m_buffer = nullptr;
 	return *this;
 }
 
@@ -130,6 +508,16 @@ void DataBuffer::AppendByte(uint8_t val)
 
 DataBuffer DataBuffer::GetSlice(size_t start, size_t len)
 {
+	if (DataBufferArena::GetCurrent())
+	{
+		size_t length = GetLength();
+		if (start > length)
+			start = length;
+		if (len > (length - start))
+			len = length - start;
+		return DataBuffer(GetDataAt(start), len);
+	}
+
 	BNDataBuffer* result = BNGetDataBufferSlice(m_buffer, start, len);
 	return DataBuffer(result);
 }
@@ -149,6 +537,12 @@ const uint8_t& DataBuffer::operator[](size_t offset) const
 
 string DataBuffer::ToEscapedString() const
 {
+	// Buffers with nothing to escape are returned as is without a round trip through the core
+	const uint8_t* data = (const uint8_t*)GetData();
+	size_t len = GetLength();
+	if (IsPlainEscapedString(data, len))
+		return string((const char*)data, len);
+
 	char* str = BNDataBufferToEscapedString(m_buffer);
 	string result = str;
 	BNFreeString(str);
@@ -158,28 +552,151 @@ string DataBuffer::ToEscapedString() const
 
 DataBuffer DataBuffer::FromEscapedString(const string& src)
 {
+	// The core only sees the string up to the first NUL, so the fast path stops there as well
+	const uint8_t* data = (const uint8_t*)src.data();
+	size_t len = Simd::FindByte(data, src.size(), 0);
+	if (Simd::FindByte(data, len, '\\') == len)
+		return DataBuffer(data, len);
 	return DataBuffer(BNDecodeEscapedString(src.c_str()));
 }
 
 
 string DataBuffer::ToBase64() const
 {
-	char* str = BNDataBufferToBase64(m_buffer);
-	string result = str;
-	BNFreeString(str);
+	const uint8_t* data = (const uint8_t*)GetData();
+	size_t len = GetLength();
+
+	string result(((len + 2) / 3) * 4, '\0');
+	if (result.empty())
+		return result;
+	char* dest = &result[0];
+
+	size_t i = 0;
+	size_t j = 0;
+#ifdef BN_SIMD_X86
+	if (Simd::HasSSSE3())
+		EncodeBase64SSSE3(data, len, dest, i, j);
+#endif
+	for (; (i + 3) <= len; i += 3, j += 4)
+	{
+		uint32_t value = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | (uint32_t)data[i + 2];
+		dest[j] = g_base64Alphabet[(value >> 18) & 0x3f];
+		dest[j + 1] = g_base64Alphabet[(value >> 12) & 0x3f];
+		dest[j + 2] = g_base64Alphabet[(value >> 6) & 0x3f];
+		dest[j + 3] = g_base64Alphabet[value & 0x3f];
+	}
+	if (i < len)
+	{
+		uint32_t value = (uint32_t)data[i] << 16;
+		if ((i + 1) < len)
+			value |= (uint32_t)data[i + 1] << 8;
+		dest[j] = g_base64Alphabet[(value >> 18) & 0x3f];
+		dest[j + 1] = g_base64Alphabet[(value >> 12) & 0x3f];
+		dest[j + 2] = ((i + 1) < len) ? g_base64Alphabet[(value >> 6) & 0x3f] : '=';
+		dest[j + 3] = '=';
+	}
 	return result;
 }
 
 
 DataBuffer DataBuffer::FromBase64(const string& src)
 {
-	return DataBuffer(BNDecodeBase64(src.c_str()));
+	// Only canonical padded input is decoded here. Anything else (whitespace, missing padding or
+	// invalid characters) is handed to the core so that its handling of such input is preserved.
+	size_t len = src.size();
+	if ((len % 4) != 0)
+		return DataBuffer(BNDecodeBase64(src.c_str()));
+	size_t padding = 0;
+	if ((len != 0) && (src[len - 1] == '='))
+		padding = (src[len - 2] == '=') ? 2 : 1;
+	size_t chars = len - padding;
+	size_t outputLen = ((len / 4) * 3) - padding;
+
+	// The vector decoder writes 16 bytes per 12 byte block, so leave room past the end
+	DataBuffer result(outputLen + 4);
+	uint8_t* dest = (uint8_t*)result.GetData();
+
+	size_t i = 0;
+	size_t j = 0;
+#ifdef BN_SIMD_X86
+	if (Simd::HasSSSE3())
+		DecodeBase64SSSE3(src.data(), chars, dest, i, j);
+#endif
+	uint32_t value = 0;
+	size_t bits = 0;
+	for (; i < chars; i++)
+	{
+		int8_t digit = DecodeBase64Char((uint8_t)src[i]);
+		if (digit < 0)
+			return DataBuffer(BNDecodeBase64(src.c_str()));
+		value = (value << 6) | (uint32_t)digit;
+		bits += 6;
+		if (bits >= 8)
+		{
+			bits -= 8;
+			dest[j++] = (uint8_t)(value >> bits);
+		}
+	}
+
+	result.SetSize(outputLen);
+	return result;
+}
+
+
+string DataBuffer::ToHexString(bool upperCase) const
+{
+	const uint8_t* data = (const uint8_t*)GetData();
+	size_t len = GetLength();
+	const char* digits = upperCase ? g_hexDigitsUpper : g_hexDigitsLower;
+
+	string result(len * 2, '\0');
+	if (result.empty())
+		return result;
+	char* dest = &result[0];
+
+	size_t i = 0;
+#ifdef BN_SIMD_X86
+	if (Simd::HasSSSE3())
+		EncodeHexSSSE3(data, len, dest, digits, i);
+#endif
+	for (; i < len; i++)
+	{
+		dest[i * 2] = digits[data[i] >> 4];
+		dest[(i * 2) + 1] = digits[data[i] & 0xf];
+	}
+	return result;
+}
+
+
+DataBuffer DataBuffer::FromHexString(const string& src)
+{
+	size_t len = src.size();
+	if ((len % 2) != 0)
+		return DataBuffer();
+
+	DataBuffer result(len / 2);
+	uint8_t* dest = (uint8_t*)result.GetData();
+
+	size_t i = 0;
+#ifdef BN_SIMD_X86
+	if (Simd::HasSSSE3() && !DecodeHexSSSE3(src.data(), len, dest, i))
+		return DataBuffer();
+#endif
+	for (; i < len; i += 2)
+	{
+		int8_t hi = DecodeHexDigit((uint8_t)src[i]);
+		int8_t lo = DecodeHexDigit((uint8_t)src[i + 1]);
+		if ((hi < 0) || (lo < 0))
+			return DataBuffer();
+		dest[i / 2] = (uint8_t)((hi << 4) | lo);
+	}
+	return result;
 }
 
 
 bool DataBuffer::ZlibCompress(DataBuffer& output) const
 {
-	BNDataBuffer* result = BNZlibCompress(output.m_buffer);
+	BNDataBuffer* result = BNZlibCompress(m_buffer);
 	if (!result)
 		return false;
 	output = DataBuffer(result);
@@ -189,7 +706,7 @@ bool DataBuffer::ZlibCompress(DataBuffer& output) const
 
 bool DataBuffer::ZlibDecompress(DataBuffer& output) const
 {
-	BNDataBuffer* result = BNZlibDecompress(output.m_buffer);
+	BNDataBuffer* result = BNZlibDecompress(m_buffer);
 	if (!result)
 		return false;
 	output = DataBuffer(result);
@@ -0,0 +1,204 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+static bool CompareSource(const DataReference& a, const DataReference& b)
+{
+	return a.source < b.source;
+}
+
+
+static bool CompareTarget(const DataReference& a, const DataReference& b)
+{
+	if (a.target != b.target)
+		return a.target < b.target;
+	return a.source < b.source;
+}
+
+
+static DataReference MakeDataReference(uint64_t source, uint64_t target)
+{
+	DataReference result;
+	result.source = source;
+	result.target = target;
+	return result;
+}
+
+
+DataReferenceIndex::DataReferenceIndex(BinaryView* view, size_t alignment, const ParallelSearchSettings& settings):
+	m_view(view), m_settings(settings), m_targetsDirty(false)
+{
+	m_pointerSize = m_view->GetAddressSize();
+	m_alignment = (alignment == 0) ? m_pointerSize : alignment;
+	m_view->RegisterNotification(this);
+	Refresh();
+}
+
+
+DataReferenceIndex::~DataReferenceIndex()
+{
+	m_view->UnregisterNotification(this);
+}
+
+
+void DataReferenceIndex::Refresh()
+{
+	lock_guard<mutex> lock(m_mutex);
+	m_view->FindDataPointers(m_view->GetStart(), m_view->GetEnd(), m_bySource, m_alignment, m_settings);
+	m_byTarget.clear();
+	m_targetsDirty = true;
+}
+
+
+void DataReferenceIndex::Rescan(uint64_t start, uint64_t end)
+{
+	// Pointers overlapping the changed bytes start up to a pointer size before them
+	start = (start > (m_pointerSize - 1)) ? (start - (m_pointerSize - 1)) : 0;
+	start = max(start, m_view->GetStart());
+	uint64_t viewEnd = m_view->GetEnd();
+	end = min(end, viewEnd);
+	if (start >= end)
+		return;
+
+	auto first = lower_bound(m_bySource.begin(), m_bySource.end(), MakeDataReference(start, 0), CompareSource);
+	auto last = lower_bound(first, m_bySource.end(), MakeDataReference(end, 0), CompareSource);
+	first = m_bySource.erase(first, last);
+
+	// Changes are small, so they are scanned on the notifying thread
+	ParallelSearchSettings settings;
+	settings.threadCount = 1;
+	vector<DataReference> found;
+	uint64_t scanEnd = ((viewEnd - end) > (m_pointerSize - 1)) ? (end + m_pointerSize - 1) : viewEnd;
+	m_view->FindDataPointers(start, scanEnd, found, m_alignment, settings);
+	m_bySource.insert(first, found.begin(), found.end());
+	m_targetsDirty = true;
+}
+
+
+void DataReferenceIndex::ShiftSources(uint64_t offset, uint64_t len, bool inserted)
+{
+	auto first = lower_bound(m_bySource.begin(), m_bySource.end(), MakeDataReference(offset, 0), CompareSource);
+	if (!inserted)
+	{
+		auto last = lower_bound(first, m_bySource.end(), MakeDataReference(offset + len, 0), CompareSource);
+		first = m_bySource.erase(first, last);
+	}
+
+	// Moved pointers keep their values, so only their locations change
+	for (auto i = first; i != m_bySource.end(); ++i)
+	{
+		if (inserted)
+			i->source += len;
+		else
+			i->source -= len;
+	}
+
+	// Addresses after the change now hold different contents, so targets there are checked again
+	uint64_t viewStart = m_view->GetStart();
+	uint64_t viewEnd = m_view->GetEnd();
+	m_bySource.erase(remove_if(m_bySource.begin(), m_bySource.end(), [&](const DataReference& ref) {
+		return (ref.target >= offset) && ((ref.target < viewStart) || (ref.target >= viewEnd) ||
+			!m_view->IsValidOffset(ref.target));
+	}), m_bySource.end());
+	m_targetsDirty = true;
+}
+
+
+void DataReferenceIndex::UpdateTargets()
+{
+	if (!m_targetsDirty)
+		return;
+	m_byTarget = m_bySource;
+	sort(m_byTarget.begin(), m_byTarget.end(), CompareTarget);
+	m_targetsDirty = false;
+}
+
+
+size_t DataReferenceIndex::GetCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_bySource.size();
+}
+
+
+vector<DataReference> DataReferenceIndex::GetReferencesTo(uint64_t start, uint64_t len)
+{
+	vector<DataReference> result;
+	ForEachReferenceTo(start, len, [&](const DataReference& ref) {
+		result.push_back(ref);
+		return true;
+	});
+	return result;
+}
+
+
+vector<DataReference> DataReferenceIndex::GetReferencesFrom(uint64_t start, uint64_t len)
+{
+	lock_guard<mutex> lock(m_mutex);
+	auto first = lower_bound(m_bySource.begin(), m_bySource.end(), MakeDataReference(start, 0), CompareSource);
+	auto last = ((start + len) < start) ? m_bySource.end() :
+		lower_bound(first, m_bySource.end(), MakeDataReference(start + len, 0), CompareSource);
+	return vector<DataReference>(first, last);
+}
+
+
+void DataReferenceIndex::ForEachReferenceTo(uint64_t start, uint64_t len,
+	const function<bool(const DataReference& ref)>& callback)
+{
+	lock_guard<mutex> lock(m_mutex);
+	UpdateTargets();
+	auto i = lower_bound(m_byTarget.begin(), m_byTarget.end(), MakeDataReference(0, start), CompareTarget);
+	for (; (i != m_byTarget.end()) && ((i->target - start) < len); ++i)
+	{
+		if (!callback(*i))
+			break;
+	}
+}
+
+
+void DataReferenceIndex::OnBinaryDataWritten(BinaryView*, uint64_t offset, size_t len)
+{
+	lock_guard<mutex> lock(m_mutex);
+	Rescan(offset, offset + len);
+}
+
+
+void DataReferenceIndex::OnBinaryDataInserted(BinaryView*, uint64_t offset, size_t len)
+{
+	lock_guard<mutex> lock(m_mutex);
+	ShiftSources(offset, len, true);
+	Rescan(offset, offset + len);
+}
+
+
+void DataReferenceIndex::OnBinaryDataRemoved(BinaryView*, uint64_t offset, uint64_t len)
+{
+	lock_guard<mutex> lock(m_mutex);
+	ShiftSources(offset, len, false);
+	Rescan(offset, offset);
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+DataVariableList::DataVariableList(BinaryView* view)
+{
+	m_vars = BNGetDataVariables(view->GetObject(), &m_count);
+	sort(m_vars, m_vars + m_count,
+		[](const BNDataVariable& a, const BNDataVariable& b) { return a.address < b.address; });
+}
+
+
+DataVariableList::~DataVariableList()
+{
+	BNFreeDataVariables(m_vars, m_count);
+}
+
+
+Ref<Type> DataVariableList::GetType(size_t i) const
+{
+	BNType* type = m_vars[i].type;
+	if (!type)
+		return nullptr;
+
+	lock_guard<mutex> lock(m_typeMutex);
+	auto existing = m_types.find(type);
+	if (existing != m_types.end())
+		return existing->second;
+	Ref<Type> result = new Type(BNNewTypeReference(type));
+	m_types[type] = result;
+	return result;
+}
+
+
+DataVariable DataVariableList::GetDataVariable(size_t i) const
+{
+	DataVariable result;
+	result.address = m_vars[i].address;
+	result.type = GetType(i);
+	result.autoDiscovered = m_vars[i].autoDiscovered;
+	return result;
+}
+
+
+size_t DataVariableList::GetIndexAtOrAfter(uint64_t addr) const
+{
+	return (size_t)(lower_bound(m_vars, m_vars + m_count, addr,
+		[](const BNDataVariable& var, uint64_t value) { return var.address < value; }) - m_vars);
+}
+
+
+bool DataVariableList::GetIndexAt(uint64_t addr, size_t& index) const
+{
+	index = GetIndexAtOrAfter(addr);
+	return (index < m_count) && (m_vars[index].address == addr);
+}
+
+
+pair<size_t, size_t> DataVariableList::GetRange(uint64_t start, uint64_t len) const
+{
+	size_t first = GetIndexAtOrAfter(start);
+	size_t last = ((start + len) < start) ? m_count : GetIndexAtOrAfter(start + len);
+	return pair<size_t, size_t>(first, last);
+}
+
+
+void DataVariableList::ForEachDataVariable(uint64_t start, uint64_t len,
+	const function<bool(const DataVariable& var)>& callback) const
+{
+	pair<size_t, size_t> range = GetRange(start, len);
+	for (size_t i = range.first; i < range.second; i++)
+	{
+		if (!callback(GetDataVariable(i)))
+			break;
+	}
+}
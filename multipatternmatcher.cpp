@@ -0,0 +1,231 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <queue>
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+MultiPatternMatcher::MultiPatternMatcher(const vector<BytePattern>& patterns): m_patterns(patterns), m_maxLength(0)
+{
+	// Build the trie over each pattern's longest fully specified run. Node 0 is the root.
+	vector<vector<pair<uint8_t, uint32_t>>> children(1);
+	vector<vector<uint32_t>> outputs(1);
+	m_keyOffsets.resize(m_patterns.size(), 0);
+	m_keyLengths.resize(m_patterns.size(), 0);
+
+	for (size_t i = 0; i < m_patterns.size(); i++)
+	{
+		const vector<uint8_t>& bytes = m_patterns[i].GetBytes();
+		const vector<uint8_t>& mask = m_patterns[i].GetMask();
+		m_maxLength = max(m_maxLength, bytes.size());
+
+		size_t bestStart = 0;
+		size_t bestLength = 0;
+		size_t runStart = 0;
+		for (size_t j = 0; j <= bytes.size(); j++)
+		{
+			if ((j < bytes.size()) && (mask[j] == 0xff))
+				continue;
+			if ((j - runStart) > bestLength)
+			{
+				bestStart = runStart;
+				bestLength = j - runStart;
+			}
+			runStart = j + 1;
+		}
+		if (bestLength == 0)
+		{
+			if (!bytes.empty())
+				m_unindexed.push_back(i);
+			continue;
+		}
+		m_keyOffsets[i] = bestStart;
+		m_keyLengths[i] = bestLength;
+
+		uint32_t node = 0;
+		for (size_t j = bestStart; j < (bestStart + bestLength); j++)
+		{
+			uint32_t next = 0;
+			for (auto& edge : children[node])
+			{
+				if (edge.first == bytes[j])
+				{
+					next = edge.second;
+					break;
+				}
+			}
+			if (next == 0)
+			{
+				next = (uint32_t)children.size();
+				children[node].push_back(pair<uint8_t, uint32_t>(bytes[j], next));
+				children.push_back(vector<pair<uint8_t, uint32_t>>());
+				outputs.push_back(vector<uint32_t>());
+			}
+			node = next;
+		}
+		outputs[node].push_back((uint32_t)i);
+	}
+
+	// Flatten the trie into sorted edge arrays so lookups touch contiguous memory
+	size_t stateCount = children.size();
+	m_edgeStart.resize(stateCount + 1);
+	m_outputStart.resize(stateCount + 1);
+	for (size_t i = 0; i < stateCount; i++)
+	{
+		sort(children[i].begin(), children[i].end());
+		m_edgeStart[i] = (uint32_t)m_edgeBytes.size();
+		for (auto& edge : children[i])
+		{
+			m_edgeBytes.push_back(edge.first);
+			m_edgeTargets.push_back(edge.second);
+		}
+		m_outputStart[i] = (uint32_t)m_outputs.size();
+		m_outputs.insert(m_outputs.end(), outputs[i].begin(), outputs[i].end());
+	}
+	m_edgeStart[stateCount] = (uint32_t)m_edgeBytes.size();
+	m_outputStart[stateCount] = (uint32_t)m_outputs.size();
+
+	for (size_t i = 0; i < 256; i++)
+		m_rootTransitions[i] = 0;
+	for (auto& edge : children[0])
+		m_rootTransitions[edge.first] = edge.second;
+
+	// Compute failure and output links breadth first, so every shallower state is finished first
+	m_fail.assign(stateCount, 0);
+	m_outputLinks.assign(stateCount, 0);
+	queue<uint32_t> pending;
+	for (auto& edge : children[0])
+		pending.push(edge.second);
+	while (!pending.empty())
+	{
+		uint32_t state = pending.front();
+		pending.pop();
+		for (auto& edge : children[state])
+		{
+			uint32_t child = edge.second;
+			uint32_t fail = GetNextState(m_fail[state], edge.first);
+			m_fail[child] = fail;
+			m_outputLinks[child] = (m_outputStart[fail] != m_outputStart[fail + 1]) ? fail : m_outputLinks[fail];
+			pending.push(child);
+		}
+	}
+}
+
+
+uint32_t MultiPatternMatcher::GetNextState(uint32_t state, uint8_t value) const
+{
+	while (state != 0)
+	{
+		uint32_t start = m_edgeStart[state];
+		uint32_t end = m_edgeStart[state + 1];
+		if ((end - start) <= 8)
+		{
+			for (uint32_t i = start; i < end; i++)
+			{
+				if (m_edgeBytes[i] == value)
+					return m_edgeTargets[i];
+			}
+		}
+		else
+		{
+			const uint8_t* first = &m_edgeBytes[start];
+			const uint8_t* last = first + (end - start);
+			const uint8_t* found = lower_bound(first, last, value);
+			if ((found != last) && (*found == value))
+				return m_edgeTargets[start + (found - first)];
+		}
+		state = m_fail[state];
+	}
+	return m_rootTransitions[value];
+}
+
+
+bool MultiPatternMatcher::ScanBlock(const uint8_t* data, size_t len, size_t scanLength, uint64_t address,
+	const function<bool(const PatternMatch& match)>& callback) const
+{
+	PatternMatch match;
+	uint32_t state = 0;
+	for (size_t i = 0; i < len; i++)
+	{
+		state = GetNextState(state, data[i]);
+		for (uint32_t output = state; output != 0; output = m_outputLinks[output])
+		{
+			for (uint32_t j = m_outputStart[output]; j < m_outputStart[output + 1]; j++)
+			{
+				// Work back from the end of the indexed run to where the whole pattern starts
+				size_t pattern = m_outputs[j];
+				const BytePattern& entry = m_patterns[pattern];
+				size_t prefixLength = m_keyOffsets[pattern] + m_keyLengths[pattern];
+				if ((i + 1) < prefixLength)
+					continue;
+				size_t start = (i + 1) - prefixLength;
+				if ((start >= scanLength) || ((start + entry.GetLength()) > len))
+					continue;
+				if ((m_keyLengths[pattern] != entry.GetLength()) && !entry.Matches(data + start))
+					continue;
+				match.pattern = pattern;
+				match.address = address + start;
+				if (!callback(match))
+					return false;
+			}
+		}
+	}
+
+	for (auto pattern : m_unindexed)
+	{
+		const BytePattern& entry = m_patterns[pattern];
+		size_t offset = 0;
+		while (entry.Find(data, len, offset, offset) && (offset < scanLength))
+		{
+			match.pattern = pattern;
+			match.address = address + offset;
+			if (!callback(match))
+				return false;
+			offset++;
+		}
+	}
+	return true;
+}
+
+
+bool MultiPatternMatcher::Scan(const uint8_t* data, size_t len, uint64_t address,
+	const function<bool(const PatternMatch& match)>& callback) const
+{
+	return ScanBlock(data, len, len, address, callback);
+}
+
+
+bool MultiPatternMatcher::Scan(BinaryView* view, uint64_t start, uint64_t end,
+	const function<bool(const PatternMatch& match)>& callback) const
+{
+	if (m_maxLength == 0)
+		return true;
+
+	// Blocks overlap by one less than the longest pattern. Each block is scanned from the initial
+	// state and only reports matches starting before the overlap, so every match is reported once.
+	return view->ScanData(start, end, m_maxLength - 1, [&](const DataScanBlock& block) {
+		return ScanBlock(block.data, block.length, block.scanLength, block.address, callback);
+	});
+}
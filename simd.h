@@ -0,0 +1,162 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// Internal helpers for the vectorized code paths in the API wrapper. This header is not part of the
+// public API and is only included from the wrapper's source files.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BN_SIMD_X86
+#define BN_SIMD_TARGET(features) __attribute__((target(features)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define BN_SIMD_X86
+#define BN_SIMD_TARGET(features)
+#endif
+
+// SSE2 is part of the x86-64 baseline, so code using only SSE2 does not need a runtime check
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define BN_SIMD_SSE2
+#endif
+
+
+namespace BinaryNinja
+{
+	namespace Simd
+	{
+#ifdef BN_SIMD_X86
+#ifdef _MSC_VER
+		inline bool DetectSSSE3()
+		{
+			int info[4];
+			__cpuid(info, 1);
+			return (info[2] & (1 << 9)) != 0;
+		}
+
+		inline bool DetectAVX2()
+		{
+			int info[4];
+			__cpuid(info, 1);
+			// AVX state must be enabled by the OS (OSXSAVE and XCR0 bits 1 and 2) before AVX2 can be used
+			if (((info[2] & (1 << 27)) == 0) || ((info[2] & (1 << 28)) == 0))
+				return false;
+			if ((_xgetbv(0) & 6) != 6)
+				return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+		}
+#else
+		inline bool DetectSSSE3()
+		{
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("ssse3");
+		}
+
+		inline bool DetectAVX2()
+		{
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+		}
+#endif
+
+		inline bool HasSSSE3()
+		{
+			static const bool result = DetectSSSE3();
+			return result;
+		}
+
+		inline bool HasAVX2()
+		{
+			static const bool result = DetectAVX2();
+			return result;
+		}
+#else
+		inline bool HasSSSE3() { return false; }
+		inline bool HasAVX2() { return false; }
+#endif
+
+		inline uint32_t CountTrailingZeros(uint32_t value)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanForward(&index, value);
+			return (uint32_t)index;
+#else
+			return (uint32_t)__builtin_ctz(value);
+#endif
+		}
+
+		inline uint32_t CountTrailingZeros64(uint64_t value)
+		{
+			if ((uint32_t)value != 0)
+				return CountTrailingZeros((uint32_t)value);
+			return 32 + CountTrailingZeros((uint32_t)(value >> 32));
+		}
+
+		// Returns the index of the first byte equal to value, or len if there is none
+		inline size_t FindByte(const uint8_t* data, size_t len, uint8_t value)
+		{
+			size_t i = 0;
+#ifdef BN_SIMD_SSE2
+			__m128i needle = _mm_set1_epi8((char)value);
+			for (; (i + 16) <= len; i += 16)
+			{
+				__m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+				uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+				if (mask)
+					return i + CountTrailingZeros(mask);
+			}
+#endif
+			const void* found = memchr(data + i, value, len - i);
+			if (!found)
+				return len;
+			return (size_t)((const uint8_t*)found - data);
+		}
+
+		// Returns the index of the first zero 16-bit unit (in units), or count if there is none
+		inline size_t FindZero16(const uint8_t* data, size_t count)
+		{
+			size_t i = 0;
+#ifdef BN_SIMD_SSE2
+			__m128i zero = _mm_setzero_si128();
+			for (; (i + 8) <= count; i += 8)
+			{
+				__m128i block = _mm_loadu_si128((const __m128i*)(data + (i * 2)));
+				uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(block, zero));
+				if (mask)
+					return i + (CountTrailingZeros(mask) / 2);
+			}
+#endif
+			for (; i < count; i++)
+			{
+				if ((data[i * 2] == 0) && (data[(i * 2) + 1] == 0))
+					return i;
+			}
+			return count;
+		}
+	}
+}
@@ -0,0 +1,216 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+static BNStringReference MakeStringReference(uint64_t start, BNStringType type, size_t length)
+{
+	BNStringReference result;
+	result.type = type;
+	result.start = start;
+	result.length = length;
+	return result;
+}
+
+
+static bool StringLess(const BNStringReference& a, const BNStringReference& b)
+{
+	if (a.start != b.start)
+		return a.start < b.start;
+	return a.type < b.type;
+}
+
+
+static bool StringStartLess(const BNStringReference& str, uint64_t addr)
+{
+	return str.start < addr;
+}
+
+
+StringIndex::StringIndex(BinaryView* view): m_view(view), m_loading(false)
+{
+	m_view->RegisterNotification(this);
+	Refresh();
+}
+
+
+StringIndex::~StringIndex()
+{
+	m_view->UnregisterNotification(this);
+}
+
+
+void StringIndex::Refresh()
+{
+	// The list is fetched without holding the lock, since analysis may be waiting on it to deliver a
+	// notification. Changes that arrive in the meantime stay pending and are applied on top of the
+	// snapshot, so they take precedence over it.
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_strings.clear();
+		m_pending.clear();
+		m_loading = true;
+	}
+
+	vector<BNStringReference> strings = m_view->GetStrings();
+	stable_sort(strings.begin(), strings.end(), StringLess);
+	strings.erase(unique(strings.begin(), strings.end(), [](const BNStringReference& a, const BNStringReference& b) {
+		return (a.start == b.start) && (a.type == b.type);
+	}), strings.end());
+
+	lock_guard<mutex> lock(m_mutex);
+	m_strings.swap(strings);
+	m_loading = false;
+}
+
+
+void StringIndex::ApplyPending() const
+{
+	// Merging is linear in the size of the list, so changes are batched until something reads them.
+	// While a refresh is loading, the pending changes are kept for the snapshot instead.
+	if (m_pending.empty() || m_loading)
+		return;
+
+	vector<BNStringReference> merged;
+	merged.reserve(m_strings.size() + m_pending.size());
+	auto existing = m_strings.begin();
+	for (auto& i : m_pending)
+	{
+		BNStringReference str = MakeStringReference(i.first.first, i.first.second, i.second.length);
+		while ((existing != m_strings.end()) && StringLess(*existing, str))
+			merged.push_back(*existing++);
+		if ((existing != m_strings.end()) && !StringLess(str, *existing))
+			++existing;
+		if (i.second.present)
+			merged.push_back(str);
+	}
+	merged.insert(merged.end(), existing, m_strings.end());
+	m_strings.swap(merged);
+	m_pending.clear();
+}
+
+
+vector<BNStringReference>::const_iterator StringIndex::LowerBound(uint64_t addr) const
+{
+	return lower_bound(m_strings.begin(), m_strings.end(), addr, StringStartLess);
+}
+
+
+size_t StringIndex::GetCount() const
+{
+	lock_guard<mutex> lock(m_mutex);
+	ApplyPending();
+	return m_strings.size();
+}
+
+
+size_t StringIndex::GetCount(uint64_t start, uint64_t len) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	ApplyPending();
+	auto first = LowerBound(start);
+	auto last = ((start + len) < start) ? m_strings.end() : LowerBound(start + len);
+	return (size_t)(last - first);
+}
+
+
+bool StringIndex::GetStringAt(uint64_t addr, BNStringReference& result) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	ApplyPending();
+	auto i = LowerBound(addr);
+	if ((i == m_strings.end()) || (i->start != addr))
+		return false;
+	result = *i;
+	return true;
+}
+
+
+bool StringIndex::GetNextString(uint64_t addr, BNStringReference& result) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	ApplyPending();
+	auto i = LowerBound(addr);
+	if (i == m_strings.end())
+		return false;
+	result = *i;
+	return true;
+}
+
+
+vector<BNStringReference> StringIndex::GetStrings(uint64_t start, uint64_t len) const
+{
+	vector<BNStringReference> result;
+	ForEachString(start, len, [&](const BNStringReference& str) {
+		result.push_back(str);
+		return true;
+	});
+	return result;
+}
+
+
+vector<BNStringReference> StringIndex::GetPage(uint64_t addr, size_t maxCount) const
+{
+	lock_guard<mutex> lock(m_mutex);
+	ApplyPending();
+	auto first = LowerBound(addr);
+	auto last = first + (ptrdiff_t)min(maxCount, (size_t)(m_strings.end() - first));
+	return vector<BNStringReference>(first, last);
+}
+
+
+void StringIndex::ForEachString(uint64_t start, uint64_t len,
+	const function<bool(const BNStringReference& str)>& callback) const
+{
+	uint64_t end = start + len;
+	lock_guard<mutex> lock(m_mutex);
+	ApplyPending();
+	for (auto i = LowerBound(start); i != m_strings.end(); ++i)
+	{
+		if ((end >= start) && (i->start >= end))
+			break;
+		if (!callback(*i))
+			break;
+	}
+}
+
+
+void StringIndex::OnStringFound(BinaryView*, BNStringType type, uint64_t offset, size_t len)
+{
+	lock_guard<mutex> lock(m_mutex);
+	PendingString& pending = m_pending[Key(offset, type)];
+	pending.present = true;
+	pending.length = len;
+}
+
+
+void StringIndex::OnStringRemoved(BinaryView*, BNStringType type, uint64_t offset, size_t)
+{
+	lock_guard<mutex> lock(m_mutex);
+	PendingString& pending = m_pending[Key(offset, type)];
+	pending.present = false;
+	pending.length = 0;
+}
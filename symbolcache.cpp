@@ -0,0 +1,416 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+SymbolCache::SymbolCache(BinaryView* view): m_view(BNNewViewReference(view->GetObject())), m_liveCount(0),
+	m_recentLimit(MinRecentLimit)
+{
+	Refresh();
+}
+
+
+SymbolCache::~SymbolCache()
+{
+	BNFreeBinaryView(m_view);
+}
+
+
+uint64_t SymbolCache::HashName(const string& name)
+{
+	uint64_t hash = 0xcbf29ce484222325LL;
+	for (auto i : name)
+	{
+		hash ^= (uint8_t)i;
+		hash *= 0x100000001b3LL;
+	}
+	return hash;
+}
+
+
+uint32_t SymbolCache::FindName(const string& name, uint64_t hash) const
+{
+	if (m_nameTable.empty())
+		return NoEntry;
+	size_t mask = m_nameTable.size() - 1;
+	for (size_t i = (size_t)hash & mask; ; i = (i + 1) & mask)
+	{
+		uint32_t id = m_nameTable[i];
+		if (id == NoEntry)
+			return NoEntry;
+		if ((m_names[id].hash == hash) && (m_names[id].name == name))
+			return id;
+	}
+}
+
+
+void SymbolCache::GrowNameTable()
+{
+	// Keep the table at most half full so that probe sequences stay short
+	size_t size = max(m_nameTable.size() * 2, (size_t)1024);
+	m_nameTable.assign(size, (uint32_t)NoEntry);
+	size_t mask = size - 1;
+	for (uint32_t id = 0; id < (uint32_t)m_names.size(); id++)
+	{
+		size_t i = (size_t)m_names[id].hash & mask;
+		while (m_nameTable[i] != NoEntry)
+			i = (i + 1) & mask;
+		m_nameTable[i] = id;
+	}
+}
+
+
+uint32_t SymbolCache::InternName(const string& name)
+{
+	uint64_t hash = HashName(name);
+	uint32_t id = FindName(name, hash);
+	if (id != NoEntry)
+		return id;
+	return AddName(name, hash);
+}
+
+
+uint32_t SymbolCache::AddName(const string& name, uint64_t hash)
+{
+	NameRecord record;
+	record.name = name;
+	record.hash = hash;
+	uint32_t id = (uint32_t)m_names.size();
+	m_names.push_back(record);
+
+	if ((m_names.size() * 2) > m_nameTable.size())
+	{
+		GrowNameTable();
+		return id;
+	}
+
+	size_t mask = m_nameTable.size() - 1;
+	size_t i = (size_t)hash & mask;
+	while (m_nameTable[i] != NoEntry)
+		i = (i + 1) & mask;
+	m_nameTable[i] = id;
+	return id;
+}
+
+
+void SymbolCache::SetRecentLimit()
+{
+	// Inserting into the recent array costs up to its size, and each merge costs the size of the whole
+	// index spread over the inserts since the last one, so both are kept near the square root
+	m_recentLimit = MinRecentLimit;
+	while ((m_recentLimit * m_recentLimit) < m_addresses.size())
+		m_recentLimit *= 2;
+}
+
+
+void SymbolCache::MergeRecentAddresses()
+{
+	// Removed entries leave their address behind, so drop those while merging
+	vector<pair<uint64_t, uint32_t>> merged;
+	merged.reserve(m_liveCount);
+	auto i = m_addresses.begin();
+	auto j = m_recentAddresses.begin();
+	while ((i != m_addresses.end()) || (j != m_recentAddresses.end()))
+	{
+		const pair<uint64_t, uint32_t>& next = ((j == m_recentAddresses.end()) ||
+			((i != m_addresses.end()) && (*i < *j))) ? *i++ : *j++;
+		if (m_entries[next.second].live)
+			merged.push_back(next);
+	}
+	m_addresses.swap(merged);
+	m_recentAddresses.clear();
+	SetRecentLimit();
+}
+
+
+uint32_t SymbolCache::FindAddressIn(const vector<pair<uint64_t, uint32_t>>& addresses, uint64_t addr) const
+{
+	auto i = lower_bound(addresses.begin(), addresses.end(), pair<uint64_t, uint32_t>(addr, 0));
+	for (; (i != addresses.end()) && (i->first == addr); ++i)
+	{
+		if (m_entries[i->second].live)
+			return i->second;
+	}
+	return NoEntry;
+}
+
+
+uint32_t SymbolCache::FindAddress(uint64_t addr) const
+{
+	uint32_t id = FindAddressIn(m_recentAddresses, addr);
+	if (id != NoEntry)
+		return id;
+	return FindAddressIn(m_addresses, addr);
+}
+
+
+void SymbolCache::AddAddress(uint64_t addr, uint32_t id)
+{
+	// New addresses go into a small sorted array of their own that is merged into the main one once it
+	// fills up, so that an update does not have to move the whole index
+	pair<uint64_t, uint32_t> value(addr, id);
+	m_recentAddresses.insert(upper_bound(m_recentAddresses.begin(), m_recentAddresses.end(), value), value);
+	if (m_recentAddresses.size() >= m_recentLimit)
+		MergeRecentAddresses();
+}
+
+
+uint32_t SymbolCache::InsertEntry(Symbol* sym, uint64_t addr, const uint32_t* names)
+{
+	uint32_t id = (uint32_t)m_entries.size();
+	Entry entry;
+	entry.symbol = sym;
+	entry.address = addr;
+	for (size_t i = 0; i < 3; i++)
+		entry.names[i] = names[i];
+	entry.live = true;
+	m_entries.push_back(entry);
+
+	for (size_t i = 0; i < 3; i++)
+	{
+		if ((i > 0) && (names[i] == names[0]))
+			continue;
+		if ((i > 1) && (names[i] == names[1]))
+			continue;
+		m_names[names[i]].entries.push_back(id);
+	}
+	m_names[names[2]].rawNameEntries.push_back(id);
+	m_liveCount++;
+	return id;
+}
+
+
+uint32_t SymbolCache::InsertSymbol(BNSymbol* sym)
+{
+	Ref<Symbol> symbol = new Symbol(sym);
+	uint32_t names[3];
+	names[0] = InternName(symbol->GetShortName());
+	names[1] = InternName(symbol->GetFullName());
+	names[2] = InternName(symbol->GetRawName());
+	return InsertEntry(symbol, symbol->GetAddress(), names);
+}
+
+
+void SymbolCache::RemoveEntry(uint32_t id)
+{
+	Entry& entry = m_entries[id];
+	for (size_t i = 0; i < 3; i++)
+	{
+		vector<uint32_t>& entries = m_names[entry.names[i]].entries;
+		entries.erase(remove(entries.begin(), entries.end(), id), entries.end());
+	}
+	vector<uint32_t>& rawNameEntries = m_names[entry.names[2]].rawNameEntries;
+	rawNameEntries.erase(remove(rawNameEntries.begin(), rawNameEntries.end(), id), rawNameEntries.end());
+	entry.symbol = nullptr;
+	entry.live = false;
+	m_liveCount--;
+}
+
+
+void SymbolCache::SortAddresses()
+{
+	// The core keeps a single symbol per address. If the list still holds several, the one loaded last
+	// is kept, as it would have replaced the others.
+	sort(m_addresses.begin(), m_addresses.end());
+	size_t out = 0;
+	for (size_t i = 0; i < m_addresses.size(); i++)
+	{
+		if (((i + 1) < m_addresses.size()) && (m_addresses[i + 1].first == m_addresses[i].first))
+			RemoveEntry(m_addresses[i].second);
+		else
+			m_addresses[out++] = m_addresses[i];
+	}
+	m_addresses.resize(out);
+	SetRecentLimit();
+}
+
+
+void SymbolCache::Compact()
+{
+	// Names that are no longer used by any symbol are dropped along with the removed entries, and the
+	// remaining names are renumbered in the order they are first used
+	vector<Entry> entries;
+	entries.swap(m_entries);
+	vector<NameRecord> names;
+	names.swap(m_names);
+	m_nameTable.clear();
+	m_addresses.clear();
+	m_recentAddresses.clear();
+	m_liveCount = 0;
+
+	vector<uint32_t> nameIds(names.size(), (uint32_t)NoEntry);
+	for (auto& i : entries)
+	{
+		if (!i.live)
+			continue;
+		uint32_t entryNames[3];
+		for (size_t j = 0; j < 3; j++)
+		{
+			uint32_t& id = nameIds[i.names[j]];
+			if (id == NoEntry)
+				id = AddName(names[i.names[j]].name, names[i.names[j]].hash);
+			entryNames[j] = id;
+		}
+		m_addresses.push_back(pair<uint64_t, uint32_t>(i.address, InsertEntry(i.symbol, i.address, entryNames)));
+	}
+	SortAddresses();
+}
+
+
+void SymbolCache::Clear()
+{
+	m_entries.clear();
+	m_names.clear();
+	m_nameTable.clear();
+	m_addresses.clear();
+	m_recentAddresses.clear();
+	m_liveCount = 0;
+	m_recentLimit = MinRecentLimit;
+}
+
+
+void SymbolCache::Refresh()
+{
+	lock_guard<mutex> lock(m_mutex);
+	Clear();
+
+	// Symbols are loaded without looking for an existing one at the same address, and the addresses
+	// are sorted once at the end
+	size_t count;
+	BNSymbol** syms = BNGetSymbols(m_view, &count);
+	m_entries.reserve(count);
+	m_addresses.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		uint32_t id = InsertSymbol(BNNewSymbolReference(syms[i]));
+		m_addresses.push_back(pair<uint64_t, uint32_t>(m_entries[id].address, id));
+	}
+	BNFreeSymbolList(syms, count);
+	SortAddresses();
+}
+
+
+void SymbolCache::UpdateAddress(uint64_t addr)
+{
+	// Ask the core what is defined now, since it decides between user and auto symbols
+	uint32_t existing = FindAddress(addr);
+	if (existing != NoEntry)
+		RemoveEntry(existing);
+	BNSymbol* current = BNGetSymbolByAddress(m_view, addr);
+	if (current)
+		AddAddress(addr, InsertSymbol(current));
+}
+
+
+void SymbolCache::Update(Symbol* sym)
+{
+	uint64_t addr = sym->GetAddress();
+	string rawName = sym->GetRawName();
+
+	lock_guard<mutex> lock(m_mutex);
+
+	// Other symbols sharing the raw name are checked as well, in case the change replaced one of them
+	vector<uint64_t> addrs(1, addr);
+	uint32_t id = FindName(rawName, HashName(rawName));
+	if (id != NoEntry)
+	{
+		for (auto i : m_names[id].rawNameEntries)
+		{
+			if (m_entries[i].address != addr)
+				addrs.push_back(m_entries[i].address);
+		}
+	}
+	for (auto i : addrs)
+		UpdateAddress(i);
+
+	if ((m_entries.size() - m_liveCount) > max(m_liveCount, (size_t)1024))
+		Compact();
+}
+
+
+size_t SymbolCache::GetCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_liveCount;
+}
+
+
+size_t SymbolCache::GetInternedNameCount()
+{
+	lock_guard<mutex> lock(m_mutex);
+	return m_names.size();
+}
+
+
+Ref<Symbol> SymbolCache::GetSymbolByAddress(uint64_t addr)
+{
+	lock_guard<mutex> lock(m_mutex);
+	uint32_t id = FindAddress(addr);
+	if (id == NoEntry)
+		return nullptr;
+	return m_entries[id].symbol;
+}
+
+
+Ref<Symbol> SymbolCache::GetSymbolByRawName(const string& name)
+{
+	lock_guard<mutex> lock(m_mutex);
+	uint32_t id = FindName(name, HashName(name));
+	if ((id == NoEntry) || m_names[id].rawNameEntries.empty())
+		return nullptr;
+	const vector<uint32_t>& entries = m_names[id].rawNameEntries;
+	if (entries.size() == 1)
+		return m_entries[entries[0]].symbol;
+
+	// The name is ambiguous, so return the cached object for whichever symbol the core picks
+	BNSymbol* sym = BNGetSymbolByRawName(m_view, name.c_str());
+	if (!sym)
+		return nullptr;
+	uint64_t addr = BNGetSymbolAddress(sym);
+	for (auto i : entries)
+	{
+		if (m_entries[i].address == addr)
+		{
+			BNFreeSymbol(sym);
+			return m_entries[i].symbol;
+		}
+	}
+	return new Symbol(sym);
+}
+
+
+vector<Ref<Symbol>> SymbolCache::GetSymbolsByName(const string& name)
+{
+	vector<Ref<Symbol>> result;
+	lock_guard<mutex> lock(m_mutex);
+	uint32_t id = FindName(name, HashName(name));
+	if (id == NoEntry)
+		return result;
+	for (auto i : m_names[id].entries)
+		result.push_back(m_entries[i].symbol);
+	return result;
+}
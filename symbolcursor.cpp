@@ -0,0 +1,233 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, size_t pageSize):
+	m_view(view), m_start(0), m_last(~(uint64_t)0), m_next(0), m_empty(false), m_done(false), m_window(0x10000),
+	m_pageSize(max(pageSize, (size_t)1)), m_filterType(false), m_type(FunctionSymbol), m_includeNames(true),
+	m_listIndex(0), m_listOffset(0)
+{
+}
+
+
+SymbolCursor::SymbolCursor(BinaryView* view, uint64_t start, uint64_t end, size_t pageSize):
+	m_view(view), m_start(start), m_last(end - 1), m_next(start), m_empty(end <= start), m_done(m_empty), m_window(0x10000),
+	m_pageSize(max(pageSize, (size_t)1)), m_filterType(false), m_type(FunctionSymbol), m_includeNames(true),
+	m_listIndex(0), m_listOffset(0)
+{
+}
+
+
+SymbolCursor::~SymbolCursor()
+{
+	FreeLists();
+}
+
+
+void SymbolCursor::SetTypeFilter(BNSymbolType type)
+{
+	m_filterType = true;
+	m_type = type;
+}
+
+
+void SymbolCursor::ClearTypeFilter()
+{
+	m_filterType = false;
+}
+
+
+void SymbolCursor::SetIncludeNames(bool include)
+{
+	m_includeNames = include;
+}
+
+
+void SymbolCursor::Seek(uint64_t addr)
+{
+	m_page.clear();
+	m_pageSymbols.clear();
+	m_names.clear();
+	FreeLists();
+	m_next = max(addr, m_start);
+	m_done = m_empty || (m_next > m_last);
+}
+
+
+void SymbolCursor::ReleaseConsumedLists()
+{
+	// Lists before the current one have been fully handed out and are only referenced by the old page
+	for (size_t i = 0; i < m_listIndex; i++)
+		BNFreeSymbolList(m_lists[i].symbols, m_lists[i].count);
+	m_lists.erase(m_lists.begin(), m_lists.begin() + m_listIndex);
+	m_listIndex = 0;
+}
+
+
+void SymbolCursor::FreeLists()
+{
+	for (auto& i : m_lists)
+		BNFreeSymbolList(i.symbols, i.count);
+	m_lists.clear();
+	m_listIndex = 0;
+	m_listOffset = 0;
+}
+
+
+bool SymbolCursor::FetchWindow()
+{
+	// The range is tracked by its last address so that it can extend to the top of the address space
+	while (!m_done)
+	{
+		uint64_t len = min(m_window - 1, m_last - m_next) + 1;
+		size_t count;
+		BNSymbol** syms;
+		if (m_filterType)
+			syms = BNGetSymbolsOfTypeInRange(m_view->GetObject(), m_type, m_next, len, &count);
+		else
+			syms = BNGetSymbolsInRange(m_view->GetObject(), m_next, len, &count);
+		if ((len - 1) == (m_last - m_next))
+			m_done = true;
+		else
+			m_next += len;
+
+		// Aim for windows that hold between half a page and two pages of symbols. Windows may grow
+		// large enough to cross the unmapped parts of the address space in a few steps.
+		if (count > (m_pageSize * 2))
+			m_window = max(m_window / 2, (uint64_t)1);
+		else if ((count < (m_pageSize / 2)) && (m_window <= ((uint64_t)1 << 60)))
+			m_window *= (count == 0) ? 4 : 2;
+
+		if (count == 0)
+		{
+			BNFreeSymbolList(syms, count);
+			continue;
+		}
+
+		vector<pair<uint64_t, BNSymbol*>> sorted;
+		sorted.reserve(count);
+		for (size_t i = 0; i < count; i++)
+			sorted.push_back(pair<uint64_t, BNSymbol*>(BNGetSymbolAddress(syms[i]), syms[i]));
+		stable_sort(sorted.begin(), sorted.end(),
+			[](const pair<uint64_t, BNSymbol*>& a, const pair<uint64_t, BNSymbol*>& b) { return a.first < b.first; });
+		for (size_t i = 0; i < count; i++)
+			syms[i] = sorted[i].second;
+
+		SymbolList list;
+		list.symbols = syms;
+		list.count = count;
+		m_lists.push_back(list);
+		return true;
+	}
+	return false;
+}
+
+
+static size_t AppendSymbolName(vector<char>& names, char* name)
+{
+	size_t offset = names.size();
+	names.insert(names.end(), name, name + strlen(name) + 1);
+	BNFreeString(name);
+	return offset;
+}
+
+
+bool SymbolCursor::Next()
+{
+	ReleaseConsumedLists();
+	m_page.clear();
+	m_pageSymbols.clear();
+	m_names.clear();
+
+	while (m_pageSymbols.size() < m_pageSize)
+	{
+		if (m_listIndex >= m_lists.size())
+		{
+			if (!FetchWindow())
+				break;
+			continue;
+		}
+
+		SymbolList& list = m_lists[m_listIndex];
+		if (m_listOffset >= list.count)
+		{
+			m_listIndex++;
+			m_listOffset = 0;
+			continue;
+		}
+
+		// Windows fetched before the type filter was changed may hold symbols of other types
+		BNSymbol* sym = list.symbols[m_listOffset++];
+		if (m_filterType && (BNGetSymbolType(sym) != m_type))
+			continue;
+		m_pageSymbols.push_back(sym);
+	}
+
+	// Names are packed into one buffer, and the pointers are filled in once it has stopped growing
+	vector<size_t> nameOffsets;
+	if (m_includeNames)
+		nameOffsets.reserve(m_pageSymbols.size() * 3);
+	m_page.reserve(m_pageSymbols.size());
+	for (auto sym : m_pageSymbols)
+	{
+		SymbolInfo info;
+		info.type = BNGetSymbolType(sym);
+		info.address = BNGetSymbolAddress(sym);
+		info.autoDefined = BNIsSymbolAutoDefined(sym);
+		info.shortName = nullptr;
+		info.fullName = nullptr;
+		info.rawName = nullptr;
+		if (m_includeNames)
+		{
+			nameOffsets.push_back(AppendSymbolName(m_names, BNGetSymbolShortName(sym)));
+			nameOffsets.push_back(AppendSymbolName(m_names, BNGetSymbolFullName(sym)));
+			nameOffsets.push_back(AppendSymbolName(m_names, BNGetSymbolRawName(sym)));
+		}
+		m_page.push_back(info);
+	}
+
+	if (m_includeNames)
+	{
+		for (size_t i = 0; i < m_page.size(); i++)
+		{
+			m_page[i].shortName = &m_names[nameOffsets[i * 3]];
+			m_page[i].fullName = &m_names[nameOffsets[(i * 3) + 1]];
+			m_page[i].rawName = &m_names[nameOffsets[(i * 3) + 2]];
+		}
+	}
+
+	return !m_page.empty();
+}
+
+
+Ref<Symbol> SymbolCursor::GetSymbol(size_t index) const
+{
+	if (index >= m_pageSymbols.size())
+		return nullptr;
+	return new Symbol(BNNewSymbolReference(m_pageSymbols[index]));
+}
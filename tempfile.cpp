@@ -43,6 +43,15 @@ TemporaryFile::TemporaryFile(const string& contents)
 }
 
 
+TemporaryFile::TemporaryFile(const DataBufferView& contents)
+{
+	// The file is owned by the core, so its contents go through a core buffer rather than being written
+	// to the path directly
+	DataBuffer buf(contents.GetData(), contents.GetLength());
+	m_object = BNCreateTemporaryFileWithContents(buf.GetBufferObject());
+}
+
+
 TemporaryFile::TemporaryFile(BNTemporaryFile* file)
 {
 	m_object = file;
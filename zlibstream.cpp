@@ -0,0 +1,303 @@
+// Copyright (c) 2015-2016 Vector 35 LLC
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <stdio.h>
+#include <zlib.h>
+#include <algorithm>
+#include "binaryninjaapi.h"
+
+using namespace BinaryNinja;
+using namespace std;
+
+
+namespace BinaryNinja
+{
+	struct ZlibStreamState
+	{
+		z_stream stream;
+		bool compress;
+		bool initialized;
+		bool finished;
+		bool error;
+		string errorMessage;
+		vector<uint8_t> output;
+		vector<uint8_t> input;
+		function<bool(const DataBufferView&)> callback;
+		uint64_t totalInput;
+		uint64_t totalOutput;
+	};
+}
+
+
+static ZlibStreamState* CreateStreamState(bool compress, const function<bool(const DataBufferView&)>& output,
+	size_t chunkSize)
+{
+	if (chunkSize < 0x100)
+		chunkSize = 0x100;
+	ZlibStreamState* state = new ZlibStreamState;
+	memset(&state->stream, 0, sizeof(state->stream));
+	state->compress = compress;
+	state->initialized = false;
+	state->finished = false;
+	state->error = false;
+	state->output.resize(chunkSize);
+	state->callback = output;
+	state->totalInput = 0;
+	state->totalOutput = 0;
+	return state;
+}
+
+
+static bool SetError(ZlibStreamState* state, const string& message)
+{
+	if (!state->error)
+	{
+		state->error = true;
+		state->errorMessage = message;
+	}
+	return false;
+}
+
+
+static bool DeliverOutput(ZlibStreamState* state)
+{
+	size_t produced = state->output.size() - state->stream.avail_out;
+	if (produced == 0)
+		return true;
+	state->totalOutput += produced;
+	if (!state->callback(DataBufferView(&state->output[0], produced)))
+		return SetError(state, "output callback aborted the stream");
+	return true;
+}
+
+
+static bool ProcessStream(ZlibStreamState* state, const uint8_t* data, size_t len, int flush)
+{
+	if (state->error)
+		return false;
+	if (state->finished)
+	{
+		// Trailing input after the end of a compressed stream is ignored, but a finished compressor
+		// cannot accept more data
+		return !state->compress || ((len == 0) && (flush == Z_FINISH));
+	}
+
+	do
+	{
+		// avail_in is only 32 bits wide, so very large inputs are fed in pieces
+		size_t piece = min(len, (size_t)0x40000000);
+		state->stream.next_in = (Bytef*)data;
+		state->stream.avail_in = (uInt)piece;
+		data += piece;
+		len -= piece;
+		int pieceFlush = (len == 0) ? flush : Z_NO_FLUSH;
+
+		do
+		{
+			state->stream.next_out = &state->output[0];
+			state->stream.avail_out = (uInt)state->output.size();
+			uInt inputBefore = state->stream.avail_in;
+
+			int result;
+			if (state->compress)
+				result = deflate(&state->stream, pieceFlush);
+			else
+				result = inflate(&state->stream, Z_NO_FLUSH);
+			state->totalInput += inputBefore - state->stream.avail_in;
+
+			if ((result != Z_OK) && (result != Z_STREAM_END) && (result != Z_BUF_ERROR))
+				return SetError(state, state->stream.msg ? state->stream.msg : "zlib error " + to_string(result));
+			if (!DeliverOutput(state))
+				return false;
+			if (result == Z_STREAM_END)
+			{
+				state->finished = true;
+				return true;
+			}
+			if (result == Z_BUF_ERROR)
+				break;
+		}
+		while (state->stream.avail_out == 0);
+	}
+	while (len != 0);
+	return true;
+}
+
+
+static bool ProcessViewRange(ZlibStreamState* state, BinaryView* view, uint64_t offset, uint64_t len)
+{
+	if (state->input.empty())
+		state->input.resize(state->output.size());
+	while (len != 0)
+	{
+		// Nothing after the end of a compressed stream is used, so there is no point reading it
+		if (state->finished && !state->compress)
+			break;
+
+		size_t toRead = (size_t)min(len, (uint64_t)state->input.size());
+		size_t bytesRead = view->Read(&state->input[0], offset, toRead);
+		if (!ProcessStream(state, &state->input[0], bytesRead, Z_NO_FLUSH))
+			return false;
+		if (bytesRead < toRead)
+		{
+			if (state->finished && !state->compress)
+				break;
+			char message[64];
+			snprintf(message, sizeof(message), "view data could not be read at 0x%llx",
+				(unsigned long long)(offset + bytesRead));
+			return SetError(state, message);
+		}
+		offset += bytesRead;
+		len -= bytesRead;
+	}
+	return true;
+}
+
+
+ZlibCompressor::ZlibCompressor(const OutputCallback& output, int level, size_t chunkSize)
+{
+	m_state = CreateStreamState(true, output, chunkSize);
+	if (deflateInit(&m_state->stream, level) == Z_OK)
+		m_state->initialized = true;
+	else
+		SetError(m_state, "failed to initialize zlib compression");
+}
+
+
+ZlibCompressor::~ZlibCompressor()
+{
+	if (m_state->initialized)
+		deflateEnd(&m_state->stream);
+	delete m_state;
+}
+
+
+bool ZlibCompressor::Feed(const DataBufferView& input)
+{
+	return ProcessStream(m_state, (const uint8_t*)input.GetData(), input.GetLength(), Z_NO_FLUSH);
+}
+
+
+bool ZlibCompressor::Feed(BinaryView* view, uint64_t offset, uint64_t len)
+{
+	return ProcessViewRange(m_state, view, offset, len);
+}
+
+
+bool ZlibCompressor::Finish()
+{
+	return ProcessStream(m_state, nullptr, 0, Z_FINISH);
+}
+
+
+bool ZlibCompressor::IsFinished() const
+{
+	return m_state->finished;
+}
+
+
+bool ZlibCompressor::HasError() const
+{
+	return m_state->error;
+}
+
+
+string ZlibCompressor::GetErrorMessage() const
+{
+	return m_state->errorMessage;
+}
+
+
+uint64_t ZlibCompressor::GetTotalInput() const
+{
+	return m_state->totalInput;
+}
+
+
+uint64_t ZlibCompressor::GetTotalOutput() const
+{
+	return m_state->totalOutput;
+}
+
+
+ZlibDecompressor::ZlibDecompressor(const OutputCallback& output, size_t chunkSize)
+{
+	m_state = CreateStreamState(false, output, chunkSize);
+	if (inflateInit(&m_state->stream) == Z_OK)
+		m_state->initialized = true;
+	else
+		SetError(m_state, "failed to initialize zlib decompression");
+}
+
+
+ZlibDecompressor::~ZlibDecompressor()
+{
+	if (m_state->initialized)
+		inflateEnd(&m_state->stream);
+	delete m_state;
+}
+
+
+bool ZlibDecompressor::Feed(const DataBufferView& input)
+{
+	return ProcessStream(m_state, (const uint8_t*)input.GetData(), input.GetLength(), Z_NO_FLUSH);
+}
+
+
+bool ZlibDecompressor::Feed(BinaryView* view, uint64_t offset, uint64_t len)
+{
+	return ProcessViewRange(m_state, view, offset, len);
+}
+
+
+bool ZlibDecompressor::Finish()
+{
+	return m_state->finished && !m_state->error;
+}
+
+
+bool ZlibDecompressor::IsFinished() const
+{
+	return m_state->finished;
+}
+
+
+bool ZlibDecompressor::HasError() const
+{
+	return m_state->error;
+}
+
+
+string ZlibDecompressor::GetErrorMessage() const
+{
+	return m_state->errorMessage;
+}
+
+
+uint64_t ZlibDecompressor::GetTotalInput() const
+{
+	return m_state->totalInput;
+}
+
+
+uint64_t ZlibDecompressor::GetTotalOutput() const
+{
+	return m_state->totalOutput;
+}